@@ -0,0 +1,220 @@
+// src/ata.c
+// ATA/IDE driver for the primary master: LBA28 PIO plus PCI bus-master DMA.
+// All waits are polled, so it works with interrupts on or off.
+#include <stdint.h>
+#include "ata.h"
+#include "interrupt.h"
+#include "pci.h"
+#include "rprintf.h"
+#include "terminal.h"
+#include "trace.h"
+
+#define ATA_TIMEOUT 10000000u
+
+/* Physical Region Descriptor: last entry has bit 15 of 'flags' set */
+struct prd {
+    uint32_t addr;
+    uint16_t bytes;              // 0 means 64KB
+    uint16_t flags;
+} __attribute__((packed));
+
+struct ata_info ata;
+
+#define PRDT_ENTRIES (ATA_MAX_SEGS * 2 + 2)   // room for 64KB-boundary splits
+
+static struct prd prdt[PRDT_ENTRIES] __attribute__((aligned(1024)));
+static uint16_t bm_base;
+static uint16_t identify_buf[256];
+
+// --- Helpers ---------------------------------------------------------------
+static inline void ata_delay400(void) {
+    for (int i = 0; i < 4; ++i) inb(ATA_CTRL_BASE);   // alt status, ~100ns each
+}
+
+static int ata_wait_ready(void) {
+    for (uint32_t i = 0; i < ATA_TIMEOUT; ++i) {
+        uint8_t st = inb(ATA_IO_BASE + ATA_REG_STATUS);
+        if (st == 0xFF) return -1;                    // floating bus: no drive
+        if (!(st & ATA_SR_BSY)) return (st & (ATA_SR_ERR | ATA_SR_DF)) ? -1 : 0;
+    }
+    return -1;
+}
+
+static int ata_wait_drq(void) {
+    for (uint32_t i = 0; i < ATA_TIMEOUT; ++i) {
+        uint8_t st = inb(ATA_IO_BASE + ATA_REG_STATUS);
+        if (st & ATA_SR_BSY) continue;
+        if (st & (ATA_SR_ERR | ATA_SR_DF)) return -1;
+        if (st & ATA_SR_DRQ) return 0;
+    }
+    return -1;
+}
+
+static void ata_issue(uint8_t cmd, uint32_t lba, uint32_t count) {
+    outb(ATA_IO_BASE + ATA_REG_DRIVE, 0xE0 | ((lba >> 24) & 0x0F));   // master, LBA
+    outb(ATA_IO_BASE + ATA_REG_COUNT, (uint8_t)count);                 // 256 -> 0
+    outb(ATA_IO_BASE + ATA_REG_LBA0, (uint8_t)lba);
+    outb(ATA_IO_BASE + ATA_REG_LBA1, (uint8_t)(lba >> 8));
+    outb(ATA_IO_BASE + ATA_REG_LBA2, (uint8_t)(lba >> 16));
+    outb(ATA_IO_BASE + ATA_REG_COMMAND, cmd);
+}
+
+static inline void insw(uint16_t port, void *buf, uint32_t words) {
+    asm volatile("cld; rep insw" : "+D"(buf), "+c"(words) : "d"(port) : "memory");
+}
+
+static inline void outsw(uint16_t port, const void *buf, uint32_t words) {
+    asm volatile("cld; rep outsw" : "+S"(buf), "+c"(words) : "d"(port) : "memory");
+}
+
+static uint32_t segs_sectors(struct ata_seg *segs, uint32_t nsegs) {
+    uint32_t bytes = 0;
+    for (uint32_t i = 0; i < nsegs; ++i) bytes += segs[i].bytes;
+    return bytes / ATA_SECTOR_SIZE;
+}
+
+/* Write the drive's cache back so a finished write survives power loss */
+static int ata_flush(void) {
+    /* A drive still busy with the last sector ignores the command */
+    if (ata_wait_ready()) return -1;
+    outb(ATA_IO_BASE + ATA_REG_COMMAND, ATA_CMD_FLUSH);
+    ata_delay400();
+    return ata_wait_ready();
+}
+
+// --- PIO -------------------------------------------------------------------
+static int ata_pio(int write, uint32_t lba, struct ata_seg *segs, uint32_t nsegs) {
+    uint32_t count = segs_sectors(segs, nsegs);
+
+    if (ata_wait_ready()) return -1;
+    ata_issue(write ? ATA_CMD_WRITE_PIO : ATA_CMD_READ_PIO, lba, count);
+
+    for (uint32_t s = 0; s < nsegs; ++s) {
+        uint8_t *p = (uint8_t*)segs[s].buf;
+        for (uint32_t off = 0; off < segs[s].bytes; off += ATA_SECTOR_SIZE) {
+            ata_delay400();
+            if (ata_wait_drq()) return -1;
+            if (write) outsw(ATA_IO_BASE + ATA_REG_DATA, p + off, ATA_SECTOR_SIZE / 2);
+            else       insw(ATA_IO_BASE + ATA_REG_DATA, p + off, ATA_SECTOR_SIZE / 2);
+        }
+    }
+
+    ata.pio_xfers++;
+    return write ? ata_flush() : ata_wait_ready();
+}
+
+// --- Bus-master DMA --------------------------------------------------------
+static int ata_dma(int write, uint32_t lba, struct ata_seg *segs, uint32_t nsegs) {
+    uint32_t count = segs_sectors(segs, nsegs);
+
+    /* A PRD may not cross a 64KB boundary; split segments that do */
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < nsegs; ++i) {
+        uint32_t addr = (uint32_t)(uintptr_t)segs[i].buf;
+        uint32_t left = segs[i].bytes;
+        while (left) {
+            uint32_t chunk = 0x10000u - (addr & 0xFFFFu);
+            if (chunk > left) chunk = left;
+            if (n == PRDT_ENTRIES) return -1;
+            prdt[n].addr  = addr;
+            prdt[n].bytes = (uint16_t)chunk;        // 64KB wraps to 0, as the spec wants
+            prdt[n].flags = 0;
+            n++;
+            addr += chunk;
+            left -= chunk;
+        }
+    }
+    prdt[n - 1].flags = 0x8000;
+
+    if (ata_wait_ready()) return -1;
+
+    outb(bm_base + BM_COMMAND, 0);
+    outl(bm_base + BM_PRDT, (uint32_t)(uintptr_t)prdt);
+    outb(bm_base + BM_STATUS, BM_SR_ERR | BM_SR_IRQ);               // write-1-to-clear
+    outb(bm_base + BM_COMMAND, write ? 0 : BM_CMD_READ);
+
+    ata_issue(write ? ATA_CMD_WRITE_DMA : ATA_CMD_READ_DMA, lba, count);
+    outb(bm_base + BM_COMMAND, (write ? 0 : BM_CMD_READ) | BM_CMD_START);
+
+    uint8_t bst = 0;
+    uint32_t i;
+    for (i = 0; i < ATA_TIMEOUT; ++i) {
+        bst = inb(bm_base + BM_STATUS);
+        if (!(bst & BM_SR_ACTIVE) || (bst & BM_SR_ERR)) break;
+    }
+    outb(bm_base + BM_COMMAND, 0);
+    outb(bm_base + BM_STATUS, BM_SR_ERR | BM_SR_IRQ);
+
+    if (i == ATA_TIMEOUT || (bst & BM_SR_ERR)) return -1;
+    ata.dma_xfers++;
+    return write ? ata_flush() : ata_wait_ready();                  // also acks INTRQ
+}
+
+static int ata_xfer(int write, uint32_t lba, struct ata_seg *segs, uint32_t nsegs) {
+    if (!ata.present || nsegs == 0 || nsegs > ATA_MAX_SEGS) return -1;
+
+    uint32_t count = segs_sectors(segs, nsegs);
+    if (count == 0 || count > ATA_MAX_SECTORS || lba + count > ata.sectors) return -1;
+
+    TRACE(TR_ATA_IO, lba, count, write);
+    return ata.dma ? ata_dma(write, lba, segs, nsegs) : ata_pio(write, lba, segs, nsegs);
+}
+
+// --- API -------------------------------------------------------------------
+int ata_init(void) {
+    ata.present = 0;
+    ata.dma = 0;
+
+    outb(ATA_CTRL_BASE, 0x00);                                      // nIEN=0, no reset
+    outb(ATA_IO_BASE + ATA_REG_DRIVE, 0xA0);
+    ata_delay400();
+    if (inb(ATA_IO_BASE + ATA_REG_STATUS) == 0xFF) return -1;
+
+    outb(ATA_IO_BASE + ATA_REG_COUNT, 0);
+    outb(ATA_IO_BASE + ATA_REG_LBA0, 0);
+    outb(ATA_IO_BASE + ATA_REG_LBA1, 0);
+    outb(ATA_IO_BASE + ATA_REG_LBA2, 0);
+    outb(ATA_IO_BASE + ATA_REG_COMMAND, ATA_CMD_IDENTIFY);
+    ata_delay400();
+    if (inb(ATA_IO_BASE + ATA_REG_STATUS) == 0) return -1;
+    if (inb(ATA_IO_BASE + ATA_REG_LBA1) || inb(ATA_IO_BASE + ATA_REG_LBA2)) return -1;  // ATAPI
+    if (ata_wait_drq()) return -1;
+    insw(ATA_IO_BASE + ATA_REG_DATA, identify_buf, 256);
+
+    ata.sectors = identify_buf[60] | ((uint32_t)identify_buf[61] << 16);
+    ata.present = 1;
+
+    /* Bus mastering: PCI mass-storage (1) / IDE (1), BAR4 is the BM I/O block */
+    pci_bdf bdf;
+    if (pci_find_class(0x01, 0x01, &bdf) == 0) {
+        uint32_t bar4 = pci_read32(bdf, PCI_BAR4);
+        if (bar4 & 1) {
+            bm_base = (uint16_t)(bar4 & 0xFFFC);
+            pci_write32(bdf, PCI_COMMAND,
+                        pci_read32(bdf, PCI_COMMAND) | PCI_CMD_IO | PCI_CMD_BUSMASTER);
+            ata.dma = 1;
+        }
+    }
+
+    esp_printf(putc, "ATA: %u sectors (%u MB), %s\r\n", ata.sectors,
+               ata.sectors / 2048u, ata.dma ? "bus-master DMA" : "PIO");
+    return 0;
+}
+
+int ata_read_segs(uint32_t lba, struct ata_seg *segs, uint32_t nsegs) {
+    return ata_xfer(0, lba, segs, nsegs);
+}
+
+int ata_write_segs(uint32_t lba, struct ata_seg *segs, uint32_t nsegs) {
+    return ata_xfer(1, lba, segs, nsegs);
+}
+
+int ata_read(uint32_t lba, uint32_t count, void *buf) {
+    struct ata_seg seg = { buf, count * ATA_SECTOR_SIZE };
+    return ata_xfer(0, lba, &seg, 1);
+}
+
+int ata_write(uint32_t lba, uint32_t count, const void *buf) {
+    struct ata_seg seg = { (void*)buf, count * ATA_SECTOR_SIZE };
+    return ata_xfer(1, lba, &seg, 1);
+}
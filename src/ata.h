@@ -0,0 +1,76 @@
+// src/ata.h
+#ifndef ATA_H
+#define ATA_H
+
+#include <stdint.h>
+
+#define ATA_SECTOR_SIZE 512u
+#define ATA_MAX_SECTORS 256u     // per LBA28 command
+#define ATA_MAX_SEGS    32u      // scatter/gather entries per DMA command
+
+/* Primary channel, master drive (qemu -hda) */
+#define ATA_IO_BASE     0x1F0
+#define ATA_CTRL_BASE   0x3F6
+
+#define ATA_REG_DATA     0
+#define ATA_REG_ERROR    1
+#define ATA_REG_COUNT    2
+#define ATA_REG_LBA0     3
+#define ATA_REG_LBA1     4
+#define ATA_REG_LBA2     5
+#define ATA_REG_DRIVE    6
+#define ATA_REG_STATUS   7
+#define ATA_REG_COMMAND  7
+
+#define ATA_SR_ERR  0x01
+#define ATA_SR_DRQ  0x08
+#define ATA_SR_DF   0x20
+#define ATA_SR_BSY  0x80
+
+#define ATA_CMD_READ_PIO   0x20
+#define ATA_CMD_WRITE_PIO  0x30
+#define ATA_CMD_READ_DMA   0xC8
+#define ATA_CMD_WRITE_DMA  0xCA
+#define ATA_CMD_FLUSH      0xE7
+#define ATA_CMD_IDENTIFY   0xEC
+
+/* PCI IDE bus-master registers (offsets from BAR4) */
+#define BM_COMMAND  0
+#define BM_STATUS   2
+#define BM_PRDT     4
+#define BM_CMD_START 0x01
+#define BM_CMD_READ  0x08        // device -> memory
+#define BM_SR_ACTIVE 0x01
+#define BM_SR_ERR    0x02
+#define BM_SR_IRQ    0x04
+
+/* One piece of a transfer: physical (== kernel virtual) address and length.
+   Length must be a multiple of the sector size; DMA segments must not cross
+   a 64KB boundary, which 4KB-aligned block buffers never do. */
+struct ata_seg {
+    void    *buf;
+    uint32_t bytes;
+};
+
+struct ata_info {
+    int      present;
+    int      dma;                // bus-master DMA available
+    uint32_t sectors;            // LBA28 capacity
+    uint32_t pio_xfers, dma_xfers;
+};
+
+extern struct ata_info ata;
+
+/* Probe the drive and the PCI IDE controller. Returns 0 if a disk is there. */
+int ata_init(void);
+
+/* Transfer sectors starting at 'lba' into/out of the segment list.
+   Uses one DMA command when possible, PIO otherwise. Returns 0 on success. */
+int ata_read_segs(uint32_t lba, struct ata_seg *segs, uint32_t nsegs);
+int ata_write_segs(uint32_t lba, struct ata_seg *segs, uint32_t nsegs);
+
+/* Contiguous-buffer conveniences */
+int ata_read(uint32_t lba, uint32_t count, void *buf);
+int ata_write(uint32_t lba, uint32_t count, const void *buf);
+
+#endif // ATA_H
@@ -0,0 +1,217 @@
+// src/bcache.c
+// Block buffer cache over the ATA disk: hash-indexed, LRU-replaced 4KB
+// blocks with read-ahead on misses and write-back of dirty blocks.
+#include <stdint.h>
+#include "ata.h"
+#include "bcache.h"
+#include "cpu.h"
+#include "sched.h"
+
+struct bcache_stats bcache_stats;
+
+static uint8_t    bdata[BCACHE_NBUF][BLOCK_SIZE] __attribute__((aligned(4096)));
+static struct buf bufs[BCACHE_NBUF];
+static struct buf *htab[BCACHE_HASH];
+static struct buf lru;               // sentinel: lru.next = MRU, lru.prev = LRU
+static uint32_t   ra_next;           // block right after the last read-ahead window
+static struct wait_queue busy_wait;  // bread() callers waiting for a B_BUSY block
+
+// --- Helpers ---------------------------------------------------------------
+static inline uint32_t hash(uint32_t blockno) { return ((blockno * 2654435761u) >> 26) & (BCACHE_HASH - 1u); }
+
+static void lru_unlink(struct buf *b) {
+    b->prev->next = b->next;
+    b->next->prev = b->prev;
+}
+
+static void lru_push_front(struct buf *b) {
+    b->next = lru.next;
+    b->prev = &lru;
+    lru.next->prev = b;
+    lru.next = b;
+}
+
+static void hash_remove(struct buf *b) {
+    struct buf **pp = &htab[hash(b->blockno)];
+    while (*pp && *pp != b) pp = &(*pp)->hnext;
+    if (*pp) *pp = b->hnext;
+    b->hnext = 0;
+}
+
+static void hash_insert(struct buf *b) {
+    uint32_t h = hash(b->blockno);
+    b->hnext = htab[h];
+    htab[h] = b;
+}
+
+/* A cached block, or one being read in (B_BUSY) */
+static struct buf *lookup(uint32_t blockno) {
+    for (struct buf *b = htab[hash(blockno)]; b; b = b->hnext)
+        if ((b->flags & (B_VALID | B_BUSY)) && b->blockno == blockno) return b;
+    return 0;
+}
+
+static int write_block(struct buf *b) {
+    struct ata_seg seg = { b->data, BLOCK_SIZE };
+    bcache_stats.writes++;
+    if (ata_write_segs(b->blockno * SECTORS_PER_BLOCK, &seg, 1)) return -1;
+    b->flags &= ~B_DIRTY;
+    bcache_stats.writebacks++;
+    return 0;
+}
+
+/* Least recently used unreferenced buffer, written back if dirty */
+static struct buf *victim(void) {
+    for (struct buf *b = lru.prev; b != &lru; b = b->prev) {
+        if (b->refcnt) continue;
+        if ((b->flags & B_DIRTY) && write_block(b)) continue;
+        if (b->flags & B_VALID) hash_remove(b);
+        b->flags = 0;
+        return b;
+    }
+    return 0;
+}
+
+// --- API -------------------------------------------------------------------
+void bcache_init(void) {
+    lru.next = lru.prev = &lru;
+    ra_next = 0;
+    for (uint32_t i = 0; i < BCACHE_HASH; ++i) htab[i] = 0;
+    for (uint32_t i = 0; i < BCACHE_NBUF; ++i) {
+        bufs[i].data = bdata[i];
+        bufs[i].flags = 0;
+        bufs[i].refcnt = 0;
+        bufs[i].hnext = 0;
+        lru_push_front(&bufs[i]);
+    }
+}
+
+/* Interrupts are off only while the hash and LRU list change. The device
+   transfer runs with them on; its buffers are hashed B_BUSY meanwhile, so
+   victim() skips them and bread() of one of those blocks sleeps on
+   busy_wait. ATA is polled today, so no other thread can run then. */
+uint32_t bprefetch(uint32_t blockno, uint32_t n) {
+    uint32_t fetched = 0;
+    uint32_t nblocks = ata.sectors / SECTORS_PER_BLOCK;
+    struct buf *run[BCACHE_READAHEAD * 4];
+    struct ata_seg segs[BCACHE_READAHEAD * 4];
+
+    if (n > ATA_MAX_SECTORS / SECTORS_PER_BLOCK) n = ATA_MAX_SECTORS / SECTORS_PER_BLOCK;
+    if (n > sizeof(run) / sizeof(run[0])) n = sizeof(run) / sizeof(run[0]);
+
+    while (n && blockno < nblocks) {
+        uint32_t flags = irq_save();
+
+        /* skip what is already cached, then gather the next uncached run */
+        while (n && blockno < nblocks && lookup(blockno)) { blockno++; n--; }
+
+        uint32_t k = 0;
+        while (k < n && blockno + k < nblocks && !lookup(blockno + k)) {
+            struct buf *b = victim();
+            if (!b) break;
+            b->blockno = blockno + k;
+            b->flags = B_BUSY;
+            b->refcnt = 1;                          // victim() can't pick it again
+            hash_insert(b);
+            run[k] = b;
+            segs[k].buf = b->data;
+            segs[k].bytes = BLOCK_SIZE;
+            k++;
+        }
+        irq_restore(flags);
+        if (k == 0) break;
+
+        bcache_stats.reads++;
+        int err = ata_read_segs(blockno * SECTORS_PER_BLOCK, segs, k);
+
+        /* fresh blocks go to the MRU end so the rest of this prefetch
+           does not immediately recycle them */
+        flags = irq_save();
+        for (uint32_t i = k; i-- > 0; ) {
+            run[i]->refcnt = 0;
+            if (err) {
+                hash_remove(run[i]);
+                run[i]->flags = 0;
+                continue;
+            }
+            run[i]->flags = B_VALID;
+            lru_unlink(run[i]);
+            lru_push_front(run[i]);
+        }
+        wake_up(&busy_wait);
+        irq_restore(flags);
+        if (err) break;
+
+        fetched += k;
+        blockno += k;
+        n -= k;
+    }
+    return fetched;
+}
+
+struct buf *bread(uint32_t blockno) {
+    uint32_t flags = irq_save();
+    struct buf *b = lookup(blockno);
+    int fetched = 0;
+
+    while (!b || (b->flags & B_BUSY)) {
+        if (b) {
+            sleep_on(&busy_wait);                   // another thread is reading it in
+        } else if (fetched) {
+            break;                                  // I/O error
+        } else {
+            bcache_stats.misses++;
+            /* Read ahead only when the miss continues the previous window, so
+               random access does not flush the working set with guesses. */
+            uint32_t want = (blockno == ra_next) ? BCACHE_READAHEAD : 1;
+            irq_restore(flags);
+            uint32_t got = bprefetch(blockno, want);
+            flags = irq_save();
+            if (got > 1) bcache_stats.readahead += got - 1;
+            ra_next = blockno + (got ? got : 1);
+            fetched = 1;
+        }
+        b = lookup(blockno);
+    }
+
+    if (b) {
+        if (!fetched) bcache_stats.hits++;
+        b->refcnt++;
+        lru_unlink(b);
+        lru_push_front(b);
+    }
+    irq_restore(flags);
+    return b;
+}
+
+void bwrite(struct buf *b) {
+    b->flags |= B_DIRTY;
+}
+
+void brelse(struct buf *b) {
+    uint32_t flags = irq_save();
+    if (b->refcnt) b->refcnt--;
+    irq_restore(flags);
+}
+
+int bsync(void) {
+    uint32_t flags = irq_save();
+    int err = 0;
+    for (uint32_t i = 0; i < BCACHE_NBUF; ++i)
+        if ((bufs[i].flags & (B_VALID | B_DIRTY)) == (B_VALID | B_DIRTY))
+            err |= write_block(&bufs[i]);
+    irq_restore(flags);
+    return err;
+}
+
+void bcache_invalidate(void) {
+    uint32_t flags = irq_save();
+    for (uint32_t i = 0; i < BCACHE_NBUF; ++i) {
+        struct buf *b = &bufs[i];
+        if (b->refcnt || !(b->flags & B_VALID)) continue;
+        if ((b->flags & B_DIRTY) && write_block(b)) continue;
+        hash_remove(b);
+        b->flags = 0;
+    }
+    irq_restore(flags);
+}
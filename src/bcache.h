@@ -0,0 +1,56 @@
+// src/bcache.h
+#ifndef BCACHE_H
+#define BCACHE_H
+
+#include <stdint.h>
+
+#define BLOCK_SIZE          4096u
+#define SECTORS_PER_BLOCK   (BLOCK_SIZE / 512u)
+#define BCACHE_NBUF         64u      // 256KB of cached blocks
+#define BCACHE_HASH         64u      // power of two
+#define BCACHE_READAHEAD    8u       // blocks fetched per miss (one DMA)
+
+#define B_VALID  0x1
+#define B_DIRTY  0x2
+#define B_BUSY   0x4                 // being read from the device
+
+struct buf {
+    uint32_t blockno;
+    uint32_t flags;
+    uint32_t refcnt;
+    struct buf *hnext;               // hash chain
+    struct buf *prev, *next;         // LRU list, head = most recently used
+    uint8_t *data;                   // BLOCK_SIZE bytes, 4KB aligned
+};
+
+struct bcache_stats {
+    uint32_t hits, misses;
+    uint32_t readahead;              // blocks brought in speculatively
+    uint32_t reads, writes;          // device requests issued
+    uint32_t writebacks;             // dirty blocks written
+};
+
+extern struct bcache_stats bcache_stats;
+
+void bcache_init(void);
+
+/* Get a block, reading it (and the following blocks) on a miss.
+   Returns 0 on I/O error. Every bread() needs a matching brelse(). */
+struct buf *bread(uint32_t blockno);
+
+/* Mark a held block dirty; it is written back on eviction or bsync() */
+void bwrite(struct buf *b);
+void brelse(struct buf *b);
+
+/* Bring up to 'n' blocks starting at 'blockno' into the cache with as few
+   device requests as possible. Already-cached blocks are skipped.
+   Returns how many blocks were read from the device. */
+uint32_t bprefetch(uint32_t blockno, uint32_t n);
+
+/* Write every dirty block back to disk */
+int bsync(void);
+
+/* Drop every unreferenced block (after writing back dirty ones) */
+void bcache_invalidate(void);
+
+#endif // BCACHE_H
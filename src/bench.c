@@ -0,0 +1,203 @@
+// src/bench.c
+// Built only into make bench kernels: empty without CONFIG_BENCH.
+#ifdef CONFIG_BENCH
+
+#include <stdint.h>
+#include "bench.h"
+#include "chan.h"
+#include "cpu.h"
+#include "fpu.h"
+#include "interrupt.h"
+#include "kstring.h"
+#include "page.h"
+#include "rprintf.h"
+#include "serial.h"
+#include "terminal.h"
+#include "trace.h"
+
+extern void outb(uint16_t _port, uint8_t val);
+
+#define SCRATCH_VA   0x00300000u  // identity-mapped scratch window for map_pages
+#define PFA_BATCH    256u
+#define CHAN_VA_A    0x04000000u  // two otherwise unmapped windows for chan_send/recv
+#define CHAN_VA_B    0x04400000u
+
+/* Results go to COM1 as "BENCH <name> <iters> <cycles> <cycles/op>" lines;
+   make bench collects them into bench_results.csv. Totals are 32-bit, so
+   iteration counts are kept small enough not to wrap. */
+static void report(const char *name, uint32_t iters, uint32_t cycles) {
+    esp_printf(serial_putc, "BENCH %s %u %u %u\r\n", (char*)name, iters, cycles, cycles / iters);
+}
+
+#define BENCH_LOOP(name, iters, stmt) do { \
+        uint32_t _t0 = (uint32_t)rdtsc(); \
+        for (uint32_t _i = 0; _i < (iters); ++_i) { stmt; } \
+        report((name), (iters), (uint32_t)rdtsc() - _t0); \
+    } while (0)
+
+static int null_sink(int c) { return c; }
+
+/* esp_printf into a small buffer, for benchmark names with a parameter */
+static char name_buf[32];
+static uint32_t name_len;
+static int name_sink(int c) {
+    if (name_len < sizeof(name_buf) - 1) name_buf[name_len++] = (char)c;
+    name_buf[name_len] = 0;
+    return c;
+}
+
+__attribute__((interrupt))
+static void bench_isr(struct interrupt_frame* frame) { }
+
+void qemu_exit(int code) {
+    outb(QEMU_EXIT_PORT, (uint8_t)code);
+    /* Not running under QEMU with isa-debug-exit: just stop */
+    asm("cli");
+    while (1) asm("hlt");
+}
+
+static void bench_pfa(void) {
+    static uint32_t frames[PFA_BATCH];
+    uint32_t alloc_cycles = 0, free_cycles = 0;
+    const uint32_t rounds = 16;
+
+    for (uint32_t r = 0; r < rounds; ++r) {
+        uint32_t t0 = (uint32_t)rdtsc();
+        for (uint32_t i = 0; i < PFA_BATCH; ++i) frames[i] = pfa_alloc();
+        uint32_t t1 = (uint32_t)rdtsc();
+        for (uint32_t i = 0; i < PFA_BATCH; ++i) pfa_free(frames[i]);
+        uint32_t t2 = (uint32_t)rdtsc();
+        alloc_cycles += t1 - t0;
+        free_cycles  += t2 - t1;
+    }
+    report("pfa_alloc", rounds * PFA_BATCH, alloc_cycles);
+    report("pfa_free",  rounds * PFA_BATCH, free_cycles);
+}
+
+static void bench_map_pages(void) {
+    struct ppage pg = { 0, 0 };
+    /* Identity mappings of otherwise unused low memory, so the live page
+       table stays correct whatever we leave behind. */
+    BENCH_LOOP("map_pages", 4096, {
+        pg.physical_addr = SCRATCH_VA + (_i & 63u) * 4096u;
+        map_pages((void*)pg.physical_addr, &pg, pd);
+    });
+}
+
+/* Back the window with CHAN_MAX_PAGES owned frames (or release them) */
+static void chan_window(uint32_t va, int fill) {
+    struct ppage pg = { 0, 0 };
+    for (uint32_t i = 0; i < CHAN_MAX_PAGES; ++i) {
+        uint32_t a = va + i * 4096u;
+        if (fill) {
+            pg.physical_addr = pfa_alloc();
+            map_pages_flags((void*)a, &pg, pd, PTE_W | PTE_OWNED);
+        } else {
+            struct page *pte = mmu_lookup_pte(pd, a, 0);
+            if (pte && pte->present) pfa_free(pte->frame << 12);
+        }
+    }
+    if (!fill) unmap_pages((void*)va, CHAN_MAX_PAGES, pd);
+}
+
+/* Cycles per message for a ping-pong A -> B -> A, so both windows are
+   fully mapped again after every round whichever path is taken. */
+static uint32_t chan_pingpong(int ch, uint32_t len, uint32_t rounds) {
+    uint32_t t0 = (uint32_t)rdtsc();
+    for (uint32_t r = 0; r < rounds; ++r) {
+        chan_send(ch, (void*)CHAN_VA_A, len);
+        chan_recv(ch, (void*)CHAN_VA_B, len);
+        chan_send(ch, (void*)CHAN_VA_B, len);
+        chan_recv(ch, (void*)CHAN_VA_A, len);
+    }
+    return ((uint32_t)rdtsc() - t0) / (2 * rounds);
+}
+
+static void bench_chan(void) {
+    static const uint32_t sizes[] = { 64, 512, 4096, 8192, 16384, 65536, 262144 };
+    const uint32_t rounds = 32;
+    uint32_t crossover = 0;
+    int ch = chan_create();
+
+    chan_window(CHAN_VA_A, 1);
+    chan_window(CHAN_VA_B, 1);
+
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        uint32_t len = sizes[i], copy = 0, remap = 0;
+
+        if (len <= CHAN_INLINE_MAX) {
+            chan_remap_min = 0xFFFFFFFFu;
+            copy = chan_pingpong(ch, len, rounds);
+            name_len = 0;
+            esp_printf(name_sink, "chan_copy_%u", len);
+            report(name_buf, 2 * rounds, copy * 2 * rounds);
+        }
+        if (len % 4096u == 0) {
+            chan_remap_min = 0;
+            remap = chan_pingpong(ch, len, rounds);
+            name_len = 0;
+            esp_printf(name_sink, "chan_remap_%u", len);
+            report(name_buf, 2 * rounds, remap * 2 * rounds);
+        }
+        if (!crossover && copy && remap && remap < copy)
+            crossover = len;
+    }
+    esp_printf(serial_putc, "# chan: remapping beats copying from %u bytes (0 = not within %u)\r\n",
+               crossover, CHAN_INLINE_MAX);
+
+    chan_remap_min = CHAN_REMAP_MIN;
+    chan_window(CHAN_VA_A, 0);
+    chan_window(CHAN_VA_B, 0);
+    chan_destroy(ch);
+}
+
+/* zero_page/copy_page use SSE2 when the CPU has it; memset_page is the
+   byte loop page faults used before */
+static void bench_page(void) {
+    extern void memset(char *s, char c, unsigned int n);
+    uint32_t a = pfa_alloc(), b = pfa_alloc();
+    void *pa = (void*)(uintptr_t)a, *pb = (void*)(uintptr_t)b;
+
+    BENCH_LOOP("memset_page", 200, memset((char*)pa, 0, 4096));
+    BENCH_LOOP("zero_page", 200, zero_page(pa));
+    BENCH_LOOP("copy_page", 200, copy_page(pb, pa));
+    BENCH_LOOP("memcpy_4k", 200, memcpy(pb, pa, 4096));
+    pfa_free(a);
+    pfa_free(b);
+}
+
+static void bench_terminal(void) {
+    BENCH_LOOP("putc", 4000, putc('a' + (_i & 15)));
+    BENCH_LOOP("scroll", 500, putc('\n'));
+}
+
+static void bench_printf(void) {
+    BENCH_LOOP("esp_printf", 2000,
+               esp_printf(null_sink, "%d %u %x %s %08x\r\n", -(int)_i, _i, _i, "bench", _i));
+}
+
+static void bench_interrupt(void) {
+    idt_set_gate(BENCH_VECTOR, (uint32_t)bench_isr, 0x08, 0x8E);
+    BENCH_LOOP("int_roundtrip", 10000, asm volatile("int $0x81" ::: "memory"));
+}
+
+void bench_run(void) {
+    uint32_t flags = irq_save();          // keep the PIT out of the numbers
+    trace_enable(0);
+
+    esp_printf(serial_putc, "BENCH-BEGIN\r\n");
+    BENCH_LOOP("rdtsc_overhead", 1000, asm volatile("" ::: "memory"));
+    bench_pfa();
+    bench_map_pages();
+    bench_chan();
+    bench_page();
+    bench_terminal();
+    bench_printf();
+    bench_interrupt();
+    esp_printf(serial_putc, "BENCH-END\r\n");
+
+    irq_restore(flags);
+    qemu_exit(0);
+}
+
+#endif // CONFIG_BENCH
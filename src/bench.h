@@ -0,0 +1,15 @@
+// src/bench.h
+#ifndef BENCH_H
+#define BENCH_H
+
+/* QEMU's isa-debug-exit device; the exit status becomes (code << 1) | 1 */
+#define QEMU_EXIT_PORT 0xF4
+#define BENCH_VECTOR   0x81     // software interrupt used for round-trip timing
+
+/* Run every microbenchmark, report over COM1 and power off QEMU.
+   Only compiled into kernels built with -DCONFIG_BENCH (make bench). */
+void bench_run(void);
+
+void qemu_exit(int code);
+
+#endif // BENCH_H
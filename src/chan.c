@@ -0,0 +1,249 @@
+// src/chan.c
+// Message channels. Small messages are copied through a per-channel byte
+// ring; large page-aligned ones never touch their payload: the frames
+// leave the sender's page table on send and enter the receiver's on
+// receive, so the cost is a few PTE writes per page plus a TLB flush.
+#include <stdint.h>
+#include "chan.h"
+#include "cpu.h"
+#include "kstring.h"
+#include "page.h"
+#include "proc.h"
+#include "swap.h"
+#include "trace.h"
+#include "vma.h"
+
+#define PAGE 4096u
+
+struct chan_msg {
+    uint32_t len;
+    uint32_t npages;                 // 0 = payload is in the byte ring
+};
+
+struct chan {
+    int used;
+    int owner;                       // pid of the creating process, 0 for the kernel
+    uint32_t msg_head, msg_tail;     // free-running; index with & (CHAN_MSGS - 1)
+    struct chan_msg msg[CHAN_MSGS];
+    uint32_t data_head, data_tail;
+    uint8_t data[CHAN_RING_BYTES];
+    uint32_t page_head, page_tail;
+    uint32_t frames[CHAN_MAX_PAGES];
+};
+
+static struct chan chans[CHAN_MAX];
+uint32_t chan_remap_min = CHAN_REMAP_MIN;
+struct chan_stats chan_stats;
+
+static struct page_directory_entry *cur_pd(void) {
+    return current ? current->pd : pd;
+}
+
+static struct chan *get(int ch) {
+    if (ch < 0 || ch >= CHAN_MAX || !chans[ch].used) return 0;
+    return &chans[ch];
+}
+
+/* A process may only move pages within its VMAs; the kernel maps what it likes */
+static int vma_allows(uint32_t va, uint32_t len, uint32_t flags) {
+    return !current || vma_covers(&current->vmas, va, va + len, flags);
+}
+
+static inline int owned(const struct page *pte) {
+    return pte && pte->present && (pte->os_specific & (PTE_OWNED >> 9));
+}
+
+// --- Byte ring ---
+
+static void ring_put(struct chan *c, const uint8_t *src, uint32_t n) {
+    uint32_t at = c->data_head & (CHAN_RING_BYTES - 1);
+    uint32_t first = CHAN_RING_BYTES - at < n ? CHAN_RING_BYTES - at : n;
+    memcpy(c->data + at, src, first);
+    memcpy(c->data, src + first, n - first);
+    c->data_head += n;
+}
+
+static void ring_get(struct chan *c, uint8_t *dst, uint32_t n) {
+    uint32_t at = c->data_tail & (CHAN_RING_BYTES - 1);
+    uint32_t first = CHAN_RING_BYTES - at < n ? CHAN_RING_BYTES - at : n;
+    memcpy(dst, c->data + at, first);
+    memcpy(dst + first, c->data, n - first);
+    c->data_tail += n;
+}
+
+// --- Page moves ---
+
+/* Every page of [va, va+len) must be mapped and owned by the address space
+   for its frame to be given away. A process's untouched pages are faulted
+   in first so a fresh buffer still qualifies, but only inside its VMAs;
+   since those faults can make the reclaimer evict pages checked earlier,
+   the range is checked again. */
+static int pages_movable(struct page_directory_entry *dir, uint32_t va, uint32_t npages) {
+    if (!vma_allows(va, npages * PAGE, VMA_READ)) return 0;
+    for (uint32_t i = 0; i < npages; ++i) {
+        if (current && !owned(mmu_lookup_pte(dir, va + i * PAGE, 0)))
+            (void)*(volatile uint8_t*)(uintptr_t)(va + i * PAGE);
+    }
+    for (uint32_t i = 0; i < npages; ++i) {
+        if (!owned(mmu_lookup_pte(dir, va + i * PAGE, 0)))
+            return 0;
+    }
+    return 1;
+}
+
+static void pages_take(struct chan *c, struct page_directory_entry *dir, uint32_t va, uint32_t npages) {
+    for (uint32_t i = 0; i < npages; ++i) {
+        struct page *pte = mmu_lookup_pte(dir, va + i * PAGE, 0);
+        c->frames[c->page_head++ & (CHAN_MAX_PAGES - 1)] = pte->frame << 12;
+        pfa_set_owner(pte->frame << 12, 0, 0);          // queued frames are not reclaimable
+        *(uint32_t*)pte = 0;
+    }
+    mmu_flush_range(va, npages);
+}
+
+/* A process receives pages only into a writable VMA: the frames get the
+   VMA's permissions and stay inside the range mmap() and brk() know about */
+static int pages_give(struct chan *c, struct page_directory_entry *dir, uint32_t va, uint32_t npages) {
+    uint32_t flags = PTE_W | PTE_OWNED | (va >= USER_BASE ? PTE_U : 0);
+    int stale = 0;
+
+    if (!vma_allows(va, npages * PAGE, VMA_WRITE)) return -1;
+
+    /* Page tables first, so running out of frames leaves the message queued */
+    for (uint32_t i = 0; i < npages; ++i)
+        if (!mmu_lookup_pte(dir, va + i * PAGE, 1)) return -1;
+
+    for (uint32_t i = 0; i < npages; ++i) {
+        uint32_t va_i = va + i * PAGE;
+        struct page *pte = mmu_lookup_pte(dir, va_i, 0);
+        if (pte->present) {
+            if (owned(pte)) pfa_free(pte->frame << 12);
+            stale = 1;
+        } else if (pte->os_specific & (PTE_SWAP >> 9)) {
+            swap_free(pte->frame);
+        }
+        struct ppage pg = { .physical_addr = c->frames[c->page_tail++ & (CHAN_MAX_PAGES - 1)], .next = 0 };
+        map_pages_flags((void*)(uintptr_t)va_i, &pg, dir, flags);
+        if (va_i >= USER_BASE) {
+            pte->dirty = 1;                             // no other copy: never drop it clean
+            pfa_set_owner(pg.physical_addr, dir, va_i);
+        }
+    }
+    if (stale) mmu_flush_range(va, npages);
+    return 0;
+}
+
+static void pages_copy_out(struct chan *c, uint8_t *dst, uint32_t len) {
+    while (len) {
+        uint32_t frame = c->frames[c->page_tail++ & (CHAN_MAX_PAGES - 1)];
+        uint32_t n = len < PAGE ? len : PAGE;
+        memcpy(dst, (const void*)(uintptr_t)frame, n);   // pool is identity-mapped
+        pfa_free(frame);
+        dst += n;
+        len -= n;
+    }
+}
+
+// --- API ---
+
+int chan_create(void) {
+    for (int i = 0; i < CHAN_MAX; ++i) {
+        if (!chans[i].used) {
+            struct chan *c = &chans[i];
+            c->used = 1;
+            c->owner = current ? current->pid : 0;
+            c->msg_head = c->msg_tail = 0;
+            c->data_head = c->data_tail = 0;
+            c->page_head = c->page_tail = 0;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void destroy(struct chan *c) {
+    while (c->page_tail != c->page_head)
+        pfa_free(c->frames[c->page_tail++ & (CHAN_MAX_PAGES - 1)]);
+    c->used = 0;
+}
+
+int chan_destroy(int ch) {
+    struct chan *c = get(ch);
+    if (!c || (current && c->owner != current->pid)) return -1;
+    destroy(c);
+    return 0;
+}
+
+void chan_release(int pid) {
+    for (int i = 0; i < CHAN_MAX; ++i)
+        if (chans[i].used && chans[i].owner == pid) destroy(&chans[i]);
+}
+
+int chan_send(int ch, const void *buf, uint32_t len) {
+    struct chan *c = get(ch);
+    uint32_t va = (uint32_t)(uintptr_t)buf;
+    uint32_t npages = len / PAGE;
+    int ret = len;
+
+    if (!c || len == 0) return -1;
+
+    uint32_t flags = irq_save();
+    if (c->msg_head - c->msg_tail == CHAN_MSGS) {
+        ret = 0;
+    } else if (len >= chan_remap_min && (va % PAGE) == 0 && (len % PAGE) == 0 &&
+               npages <= CHAN_MAX_PAGES - (c->page_head - c->page_tail) &&
+               pages_movable(cur_pd(), va, npages)) {
+        pages_take(c, cur_pd(), va, npages);
+        c->msg[c->msg_head++ & (CHAN_MSGS - 1)] = (struct chan_msg){ len, npages };
+        chan_stats.remapped_msgs++;
+        chan_stats.remapped_pages += npages;
+    } else if (len > CHAN_INLINE_MAX) {
+        ret = -1;
+    } else if (len > CHAN_RING_BYTES - (c->data_head - c->data_tail)) {
+        ret = 0;
+    } else {
+        ring_put(c, (const uint8_t*)buf, len);
+        c->msg[c->msg_head++ & (CHAN_MSGS - 1)] = (struct chan_msg){ len, 0 };
+        chan_stats.copied_msgs++;
+        chan_stats.copied_bytes += len;
+    }
+    irq_restore(flags);
+
+    TRACE(TR_CHAN_SEND, ch, len, ret > 0 ? npages : 0);
+    return ret;
+}
+
+int chan_recv(int ch, void *buf, uint32_t len) {
+    struct chan *c = get(ch);
+    uint32_t va = (uint32_t)(uintptr_t)buf;
+    int ret;
+
+    if (!c) return -1;
+
+    uint32_t flags = irq_save();
+    if (c->msg_head == c->msg_tail) {
+        irq_restore(flags);
+        return 0;
+    }
+
+    struct chan_msg *m = &c->msg[c->msg_tail & (CHAN_MSGS - 1)];
+    ret = m->len;
+    if (m->len > len) {
+        ret = -1;
+    } else if (m->npages == 0) {
+        ring_get(c, (uint8_t*)buf, m->len);
+        c->msg_tail++;
+    } else if ((va % PAGE) == 0) {
+        if (pages_give(c, cur_pd(), va, m->npages) != 0)
+            ret = -1;
+        else
+            c->msg_tail++;
+    } else {
+        pages_copy_out(c, (uint8_t*)buf, m->len);
+        c->msg_tail++;
+    }
+    irq_restore(flags);
+
+    TRACE(TR_CHAN_RECV, ch, ret, va);
+    return ret;
+}
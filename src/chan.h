@@ -0,0 +1,48 @@
+// src/chan.h
+#ifndef CHAN_H
+#define CHAN_H
+
+#include <stdint.h>
+
+#define CHAN_MAX          4
+#define CHAN_MSGS         16u        // queued messages per channel, power of two
+#define CHAN_RING_BYTES   32768u     // inline data per channel, power of two
+#define CHAN_INLINE_MAX   (CHAN_RING_BYTES / 2)
+#define CHAN_MAX_PAGES    64u        // pages in flight per channel, power of two
+#define CHAN_REMAP_MIN    8192u      // default; see make bench (chan_copy/chan_remap)
+
+/* Messages of at least chan_remap_min bytes whose buffer and length are
+   page-aligned move by page-table updates: the sender's PTEs are cleared
+   and the frames are mapped at the receiver's buffer. Everything else is
+   copied through the channel's ring. */
+extern uint32_t chan_remap_min;
+
+struct chan_stats {
+    uint32_t copied_msgs, copied_bytes;
+    uint32_t remapped_msgs, remapped_pages;
+};
+
+extern struct chan_stats chan_stats;
+
+/* Both ends work on the current address space (the running process, or
+   the kernel's). All calls return a negative value on error. A channel
+   belongs to the process that created it: only that process (or the
+   kernel) may destroy it, and it goes away when the process exits. */
+int chan_create(void);
+int chan_destroy(int ch);
+
+/* Destroy every channel of process 'pid', freeing the frames still queued */
+void chan_release(int pid);
+
+/* Queue a message. Returns len, or 0 if the channel is full. A remapped
+   buffer is left unmapped in the sender; touching it again faults in
+   fresh zeroed pages (or the file's contents for a text/data segment). */
+int chan_send(int ch, const void *buf, uint32_t len);
+
+/* Dequeue the next message into buf. Returns its length, or 0 if the
+   channel is empty; a message longer than len is left queued (-1).
+   A page-aligned buf receives remapped pages in place of whatever it
+   mapped before; otherwise they are copied out and freed. */
+int chan_recv(int ch, void *buf, uint32_t len);
+
+#endif // CHAN_H
@@ -0,0 +1,81 @@
+// src/cpu.c
+// Boot-time CPU identification. Code that can use a newer instruction
+// set asks cpu_has() instead of assuming one from the -march it was
+// built with.
+#include <stdint.h>
+#include "cpu.h"
+#include "panic.h"
+#include "rprintf.h"
+#include "terminal.h"
+
+struct cpu_info cpu_info;
+
+static void cpuid(uint32_t leaf, uint32_t *a, uint32_t *b, uint32_t *c, uint32_t *d) {
+    asm volatile("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(0));
+}
+
+/* CPUID exists iff EFLAGS.ID (bit 21) can be toggled */
+static int cpuid_supported(void) {
+    uint32_t before, after;
+    asm volatile("pushf\n\t"
+                 "pop %0\n\t"
+                 "mov %0, %1\n\t"
+                 "xor $0x200000, %1\n\t"
+                 "push %1\n\t"
+                 "popf\n\t"
+                 "pushf\n\t"
+                 "pop %1\n\t"
+                 "push %0\n\t"
+                 "popf"
+                 : "=&r"(before), "=&r"(after) : : "cc");
+    return ((before ^ after) & 0x200000) != 0;
+}
+
+void cpu_detect(void) {
+    uint32_t a, b, c, d, max;
+
+    /* Without CPUID assume a 386/486 with an FPU; fpu_init() probes it */
+    cpu_info.features = CPUID_FPU;
+    cpu_info.has_cpuid = cpuid_supported();
+    if (!cpu_info.has_cpuid) {
+#ifdef CONFIG_I686
+        panic("this kernel was built with MARCH=i686; the CPU has no CPUID");
+#endif
+        return;
+    }
+
+    cpuid(0, &max, &b, &c, &d);
+    for (int i = 0; i < 4; ++i) {
+        cpu_info.vendor[i]     = (char)(b >> (8 * i));
+        cpu_info.vendor[4 + i] = (char)(d >> (8 * i));
+        cpu_info.vendor[8 + i] = (char)(c >> (8 * i));
+    }
+    cpu_info.vendor[12] = 0;
+
+    if (max >= 1) {
+        cpuid(1, &a, &b, &c, &d);
+        cpu_info.family   = (a >> 8) & 0xF;
+        cpu_info.model    = (a >> 4) & 0xF;
+        if (cpu_info.family == 0xF) cpu_info.family += (a >> 20) & 0xFF;
+        if (cpu_info.family >= 6)   cpu_info.model  |= ((a >> 16) & 0xF) << 4;
+        cpu_info.features = d;
+    }
+    cpu_info.invlpg = 1;                         // every CPU with CPUID is a 486 or later
+#ifdef CONFIG_I686
+    if (!cpu_has(CPUID_CMOV | CPUID_TSC))
+        panic("this kernel was built with MARCH=i686; the CPU lacks cmov/rdtsc");
+#endif
+}
+
+void cpu_dump(func_ptr out) {
+    if (!cpu_info.has_cpuid) {
+        esp_printf(out, "CPU: no CPUID, assuming a 386\r\n");
+        return;
+    }
+    esp_printf(out, "CPU: %s family %u model %u%s%s%s%s%s%s\r\n", cpu_info.vendor,
+               cpu_info.family, cpu_info.model,
+               cpu_has(CPUID_TSC) ? " tsc" : "", cpu_has(CPUID_CMOV) ? " cmov" : "",
+               cpu_has(CPUID_PGE) ? " pge" : "",
+               cpu_has(CPUID_FXSR) ? " fxsr" : "", cpu_has(CPUID_SSE) ? " sse" : "",
+               cpu_has(CPUID_SSE2) ? " sse2" : "");
+}
@@ -0,0 +1,71 @@
+// src/cpu.h
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+#include "rprintf.h"
+
+/* Uniprocessor for now: per-CPU data is an array indexed by cpu_id(),
+   so growing MAX_CPUS later does not change any caller. */
+#define MAX_CPUS 1
+
+static inline unsigned int cpu_id(void) { return 0; }
+
+/* CPUID leaf 1 EDX feature bits */
+#define CPUID_FPU    (1u << 0)
+#define CPUID_PSE    (1u << 3)
+#define CPUID_TSC    (1u << 4)
+#define CPUID_PGE    (1u << 13)
+#define CPUID_CMOV   (1u << 15)
+#define CPUID_FXSR   (1u << 24)
+#define CPUID_SSE    (1u << 25)
+#define CPUID_SSE2   (1u << 26)
+
+struct cpu_info {
+    int has_cpuid;                   // 0 on a 386 and early 486s
+    char vendor[13];
+    uint32_t family, model;
+    uint32_t features;               // leaf 1 EDX, or CPUID_FPU alone without CPUID
+    int invlpg;                      // 486 or later (assumed from CPUID being there)
+};
+
+extern struct cpu_info cpu_info;
+
+static inline int cpu_has(uint32_t feature) { return (cpu_info.features & feature) == feature; }
+
+/* Fill cpu_info; run once at boot before anything calls cpu_has() or
+   rdtsc(). It does not use the console, so it can run before
+   terminal_init(). A kernel built with make MARCH=i686 (CONFIG_I686)
+   panics here on a CPU without cmov and rdtsc; panic() writes straight
+   to VGA memory, so the message still shows. */
+void cpu_detect(void);
+void cpu_dump(func_ptr out);
+
+/* Read the time-stamp counter (EDX:EAX); 0 on CPUs without one */
+static inline uint64_t rdtsc(void) {
+#if !defined(HOST_TEST) && !defined(CONFIG_I686)
+    if (!(cpu_info.features & CPUID_TSC)) return 0;
+#endif
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+
+/* Disable interrupts, returning the previous EFLAGS for irq_restore() */
+#ifndef HOST_TEST
+static inline uint32_t irq_save(void) {
+    uint32_t flags;
+    asm volatile("pushf\n\tpop %0\n\tcli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void irq_restore(uint32_t flags) {
+    asm volatile("push %0\n\tpopf" : : "r"(flags) : "memory", "cc");
+}
+#else
+static inline uint32_t irq_save(void) { return 0; }
+static inline void irq_restore(uint32_t flags) { (void)flags; }
+#endif
+
+#endif // CPU_H
@@ -0,0 +1,52 @@
+// src/elf.h
+#ifndef ELF_H
+#define ELF_H
+
+#include <stdint.h>
+
+/* The subset of the ELF32 format the program loader needs */
+#define ELF_MAGIC    0x464C457Fu   // "\x7FELF" read as a little-endian word
+#define ELFCLASS32   1
+#define ELFDATA2LSB  1
+#define ET_EXEC      2
+#define EM_386       3
+
+#define PT_LOAD      1
+
+#define PF_X         0x1
+#define PF_W         0x2
+#define PF_R         0x4
+
+struct elf32_ehdr {
+    uint32_t magic;
+    uint8_t  class;
+    uint8_t  data;
+    uint8_t  version;
+    uint8_t  pad[9];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version2;
+    uint32_t entry;
+    uint32_t phoff;
+    uint32_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint16_t phnum;
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+} __attribute__((packed));
+
+struct elf32_phdr {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t vaddr;
+    uint32_t paddr;
+    uint32_t filesz;
+    uint32_t memsz;
+    uint32_t flags;
+    uint32_t align;
+} __attribute__((packed));
+
+#endif // ELF_H
@@ -0,0 +1,359 @@
+// src/fat.c
+// Read-only FAT16 over the block cache. The FAT itself is loaded into
+// memory at mount time and every open file keeps its cluster chain as a
+// short list of extents, so a sequential read turns into a few large
+// block prefetches instead of one FAT walk per cluster.
+#include <stdint.h>
+#include "ata.h"
+#include "bcache.h"
+#include "fat.h"
+#include "kstring.h"
+#include "rprintf.h"
+#include "terminal.h"
+
+#define SECTOR          512u
+#define DIRENT_SIZE     32u
+#define FAT16_EOC       0xFFF8u
+#define PREFETCH_BLOCKS 16u          // per bprefetch() call: 64KB, a quarter of the cache
+
+struct fat_volume {
+    int      mounted;
+    uint32_t part_lba;
+    uint32_t spc;                    // sectors per cluster
+    uint32_t cluster_bytes;
+    uint32_t fat_lba;
+    uint32_t root_lba;
+    uint32_t root_entries;
+    uint32_t data_lba;
+    uint32_t nclusters;              // data clusters + 2
+};
+
+struct fat_file {
+    int      used;
+    uint32_t size;
+    uint32_t pos;
+    uint8_t  attr;
+    uint32_t first_cluster;
+    uint32_t nextents;
+    int      truncated;              // chain had more runs than FAT_MAX_EXTENTS
+    struct fat_extent ext[FAT_MAX_EXTENTS];
+};
+
+static struct fat_volume vol;
+static uint16_t fat_cache[FAT_MAX_CLUSTERS];
+static struct fat_file files[FAT_MAX_OPEN];
+
+// --- Disk helpers ----------------------------------------------------------
+static inline uint16_t rd16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t rd32(const uint8_t *p) { return rd16(p) | ((uint32_t)rd16(p + 2) << 16); }
+
+/* Copy 'len' bytes starting 'off' bytes into absolute sector 'lba' */
+static int disk_read(uint32_t lba, uint32_t off, void *dst, uint32_t len) {
+    uint8_t *d = (uint8_t*)dst;
+    uint32_t blk  = lba / SECTORS_PER_BLOCK;
+    uint32_t boff = (lba % SECTORS_PER_BLOCK) * SECTOR + off;
+
+    blk += boff / BLOCK_SIZE;
+    boff %= BLOCK_SIZE;
+    while (len) {
+        struct buf *b = bread(blk);
+        if (!b) return -1;
+        uint32_t n = BLOCK_SIZE - boff;
+        if (n > len) n = len;
+        memcpy(d, b->data + boff, n);
+        brelse(b);
+        d += n; len -= n; blk++; boff = 0;
+    }
+    return 0;
+}
+
+static inline uint32_t cluster_lba(uint32_t c) { return vol.data_lba + (c - 2) * vol.spc; }
+
+static inline int cluster_ok(uint32_t c) { return c >= 2 && c < vol.nclusters; }
+
+// --- Names and directories -------------------------------------------------
+static char upcase(char c) { return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c; }
+
+/* "grub.cfg" -> "GRUB    CFG"; returns the number of path chars consumed */
+static int to_83(const char *p, char out[11]) {
+    int i = 0, n = 0;
+    for (int k = 0; k < 11; ++k) out[k] = ' ';
+    while (p[i] && p[i] != '/' && p[i] != '.') { if (n < 8) out[n++] = upcase(p[i]); i++; }
+    if (p[i] == '.') {
+        i++;
+        n = 8;
+        while (p[i] && p[i] != '/') { if (n < 11) out[n++] = upcase(p[i]); i++; }
+    }
+    return i;
+}
+
+static void from_83(const uint8_t *raw, char out[13]) {
+    int n = 0;
+    for (int k = 0; k < 8 && raw[k] != ' '; ++k) out[n++] = (char)raw[k];
+    if (raw[8] != ' ') {
+        out[n++] = '.';
+        for (int k = 8; k < 11 && raw[k] != ' '; ++k) out[n++] = (char)raw[k];
+    }
+    out[n] = 0;
+}
+
+/* Read the idx-th raw 32-byte entry of a directory (cluster 0 = root).
+   Returns 1 if read, 0 past the end, -1 on I/O error. */
+static int dir_entry(uint32_t dir_cluster, uint32_t idx, uint8_t ent[DIRENT_SIZE]) {
+    uint32_t off = idx * DIRENT_SIZE;
+
+    if (dir_cluster == 0) {
+        if (idx >= vol.root_entries) return 0;
+        return disk_read(vol.root_lba, off, ent, DIRENT_SIZE) ? -1 : 1;
+    }
+
+    uint32_t c = dir_cluster;
+    while (off >= vol.cluster_bytes) {
+        c = fat_cache[c];
+        if (!cluster_ok(c)) return 0;
+        off -= vol.cluster_bytes;
+    }
+    return disk_read(cluster_lba(c), off, ent, DIRENT_SIZE) ? -1 : 1;
+}
+
+/* Walk 'path' from the root. Root itself yields attr DIR, cluster 0. */
+static int lookup(const char *path, struct fat_stat *st) {
+    uint32_t dir = 0;
+    uint8_t ent[DIRENT_SIZE];
+
+    st->attr = FAT_ATTR_DIR;
+    st->first_cluster = 0;
+    st->size = 0;
+
+    while (*path == '/') path++;
+    while (*path) {
+        char want[11];
+        int found = 0;
+
+        if (!(st->attr & FAT_ATTR_DIR)) return -1;
+        path += to_83(path, want);
+
+        for (uint32_t i = 0; ; ++i) {
+            int r = dir_entry(dir, i, ent);
+            if (r < 0) return -1;
+            if (r == 0 || ent[0] == 0x00) break;
+            if (ent[0] == 0xE5 || ent[11] == FAT_ATTR_LFN || (ent[11] & FAT_ATTR_VOLUME)) continue;
+            if (memcmp(ent, want, 11)) continue;
+
+            st->attr = ent[11];
+            st->first_cluster = rd16(ent + 26);
+            st->size = rd32(ent + 28);
+            found = 1;
+            break;
+        }
+        if (!found) return -1;
+
+        dir = st->first_cluster;
+        while (*path == '/') path++;
+    }
+    return 0;
+}
+
+// --- Extents ---------------------------------------------------------------
+/* Collapse the cluster chain starting at 'first' into runs */
+static void build_extents(struct fat_file *f, uint32_t first) {
+    uint32_t c = first, idx = 0;
+
+    f->nextents = 0;
+    f->truncated = 0;
+    while (cluster_ok(c)) {
+        struct fat_extent *e = f->nextents ? &f->ext[f->nextents - 1] : 0;
+        if (e && e->disk_cluster + e->count == c) {
+            e->count++;
+        } else if (f->nextents < FAT_MAX_EXTENTS) {
+            e = &f->ext[f->nextents++];
+            e->file_cluster = idx;
+            e->disk_cluster = c;
+            e->count = 1;
+        } else {
+            f->truncated = 1;
+            return;
+        }
+        idx++;
+        c = fat_cache[c];
+        if (c >= FAT16_EOC) break;
+    }
+}
+
+/* Disk cluster holding file cluster 'ci' and how many clusters from there
+   on are contiguous. Returns 0 if 'ci' is past the chain. */
+static uint32_t map_cluster(struct fat_file *f, uint32_t ci, uint32_t *run) {
+    for (uint32_t i = 0; i < f->nextents; ++i) {
+        struct fat_extent *e = &f->ext[i];
+        if (ci >= e->file_cluster && ci < e->file_cluster + e->count) {
+            *run = e->count - (ci - e->file_cluster);
+            return e->disk_cluster + (ci - e->file_cluster);
+        }
+    }
+    if (!f->truncated || !f->nextents) return 0;
+
+    /* Rare: more fragments than we cache. Walk the in-memory FAT onward. */
+    struct fat_extent *last = &f->ext[f->nextents - 1];
+    uint32_t c = last->disk_cluster + last->count - 1;
+    for (uint32_t k = last->file_cluster + last->count - 1; k < ci; ++k) {
+        c = fat_cache[c];
+        if (!cluster_ok(c)) return 0;
+    }
+    *run = 1;
+    return c;
+}
+
+// --- API -------------------------------------------------------------------
+int fat_mount(void) {
+    uint8_t sec[SECTOR];
+
+    vol.mounted = 0;
+    if (!ata.present || disk_read(0, 0, sec, SECTOR)) return -1;
+    if (sec[510] != 0x55 || sec[511] != 0xAA) return -1;
+
+    /* first partition entry; the Makefile tags it 0x83 but formats FAT16 */
+    vol.part_lba = rd32(sec + 0x1BE + 8);
+    if (disk_read(vol.part_lba, 0, sec, SECTOR)) return -1;
+    if (sec[510] != 0x55 || sec[511] != 0xAA || rd16(sec + 11) != SECTOR) return -1;
+
+    uint32_t reserved = rd16(sec + 14);
+    uint32_t nfats    = sec[16];
+    uint32_t spf      = rd16(sec + 22);
+    uint32_t total    = rd16(sec + 19) ? rd16(sec + 19) : rd32(sec + 32);
+
+    vol.spc           = sec[13];
+    vol.cluster_bytes = vol.spc * SECTOR;
+    vol.root_entries  = rd16(sec + 17);
+    vol.fat_lba       = vol.part_lba + reserved;
+    vol.root_lba      = vol.fat_lba + nfats * spf;
+    vol.data_lba      = vol.root_lba + (vol.root_entries * DIRENT_SIZE + SECTOR - 1) / SECTOR;
+    if (vol.spc == 0 || spf == 0) return -1;
+
+    uint32_t data_clusters = (total - (vol.data_lba - vol.part_lba)) / vol.spc;
+    if (data_clusters < 4085 || data_clusters >= 65525) return -1;      // not FAT16
+    vol.nclusters = data_clusters + 2;
+
+    /* The whole FAT in one go, straight into the cache array */
+    uint32_t fat_bytes = vol.nclusters * 2u;
+    uint32_t fat_secs  = (fat_bytes + SECTOR - 1) / SECTOR;
+    if (fat_secs > spf) return -1;
+    for (uint32_t s = 0; s < fat_secs; s += ATA_MAX_SECTORS) {
+        uint32_t n = fat_secs - s;
+        if (n > ATA_MAX_SECTORS) n = ATA_MAX_SECTORS;
+        if (ata_read(vol.fat_lba + s, n, (uint8_t*)fat_cache + s * SECTOR)) return -1;
+    }
+
+    for (int i = 0; i < FAT_MAX_OPEN; ++i) files[i].used = 0;
+    vol.mounted = 1;
+    esp_printf(putc, "FAT16: %u clusters x %u bytes at LBA %u\r\n",
+               data_clusters, vol.cluster_bytes, vol.part_lba);
+    return 0;
+}
+
+int fat_open(const char *path) {
+    struct fat_stat st;
+
+    if (!vol.mounted || lookup(path, &st)) return -1;
+    if (st.attr & FAT_ATTR_DIR) return -1;
+
+    for (int fd = 0; fd < FAT_MAX_OPEN; ++fd) {
+        struct fat_file *f = &files[fd];
+        if (f->used) continue;
+        f->used = 1;
+        f->size = st.size;
+        f->pos = 0;
+        f->attr = st.attr;
+        f->first_cluster = st.first_cluster;
+        build_extents(f, st.first_cluster);
+        return fd;
+    }
+    return -1;
+}
+
+int fat_close(int fd) {
+    if (fd < 0 || fd >= FAT_MAX_OPEN || !files[fd].used) return -1;
+    files[fd].used = 0;
+    return 0;
+}
+
+int fat_pread(int fd, void *buf, uint32_t n, uint32_t off) {
+    if (fd < 0 || fd >= FAT_MAX_OPEN || !files[fd].used) return -1;
+
+    struct fat_file *f = &files[fd];
+    uint8_t *dst = (uint8_t*)buf;
+    uint32_t done = 0;
+
+    if (off >= f->size) return 0;
+    if (n > f->size - off) n = f->size - off;
+
+    while (done < n) {
+        uint32_t ci   = off / vol.cluster_bytes;
+        uint32_t coff = off % vol.cluster_bytes;
+        uint32_t run;
+        uint32_t c = map_cluster(f, ci, &run);
+        if (!c) break;
+
+        /* Bytes contiguous on disk from here, capped by the request */
+        uint32_t span = run * vol.cluster_bytes - coff;
+        if (span > n - done) span = n - done;
+
+        uint32_t lba = cluster_lba(c) + coff / SECTOR;
+        uint32_t soff = coff % SECTOR;
+
+        while (span) {
+            uint32_t first = lba / SECTORS_PER_BLOCK;
+            uint32_t chunk = PREFETCH_BLOCKS * BLOCK_SIZE - ((lba % SECTORS_PER_BLOCK) * SECTOR + soff);
+            if (chunk > span) chunk = span;
+            uint32_t last = (lba + (soff + chunk - 1) / SECTOR) / SECTORS_PER_BLOCK;
+
+            bprefetch(first, last - first + 1);
+            if (disk_read(lba, soff, dst + done, chunk)) return done ? (int)done : -1;
+
+            done += chunk;
+            off  += chunk;
+            span -= chunk;
+            lba  += (soff + chunk) / SECTOR;
+            soff  = (soff + chunk) % SECTOR;
+        }
+    }
+    return (int)done;
+}
+
+int fat_read(int fd, void *buf, uint32_t n) {
+    int r = fat_pread(fd, buf, n, (fd >= 0 && fd < FAT_MAX_OPEN) ? files[fd].pos : 0);
+    if (r > 0) files[fd].pos += (uint32_t)r;
+    return r;
+}
+
+int fat_stat(const char *path, struct fat_stat *st) {
+    if (!vol.mounted) return -1;
+    return lookup(path, st);
+}
+
+int fat_fstat(int fd, struct fat_stat *st) {
+    if (fd < 0 || fd >= FAT_MAX_OPEN || !files[fd].used) return -1;
+    st->size = files[fd].size;
+    st->attr = files[fd].attr;
+    st->first_cluster = files[fd].first_cluster;
+    return 0;
+}
+
+int fat_readdir(const char *path, uint32_t idx, struct fat_dirent *out) {
+    struct fat_stat st;
+    uint8_t ent[DIRENT_SIZE];
+
+    if (!vol.mounted || lookup(path, &st) || !(st.attr & FAT_ATTR_DIR)) return -1;
+
+    for (uint32_t i = 0, seen = 0; ; ++i) {
+        int r = dir_entry(st.first_cluster, i, ent);
+        if (r <= 0) return r;
+        if (ent[0] == 0x00) return 0;
+        if (ent[0] == 0xE5 || ent[11] == FAT_ATTR_LFN || (ent[11] & FAT_ATTR_VOLUME)) continue;
+        if (seen++ < idx) continue;
+
+        from_83(ent, out->name);
+        out->attr = ent[11];
+        out->size = rd32(ent + 28);
+        return 1;
+    }
+}
@@ -0,0 +1,52 @@
+// src/fat.h
+#ifndef FAT_H
+#define FAT_H
+
+#include <stdint.h>
+
+#define FAT_MAX_OPEN      8
+#define FAT_MAX_EXTENTS   32         // contiguous cluster runs cached per file
+#define FAT_MAX_CLUSTERS  65536u     // FAT16 upper bound; the whole FAT is cached
+
+#define FAT_ATTR_RDONLY   0x01
+#define FAT_ATTR_HIDDEN   0x02
+#define FAT_ATTR_SYSTEM   0x04
+#define FAT_ATTR_VOLUME   0x08
+#define FAT_ATTR_DIR      0x10
+#define FAT_ATTR_LFN      0x0F
+
+struct fat_stat {
+    uint32_t size;
+    uint32_t first_cluster;
+    uint8_t  attr;
+};
+
+struct fat_dirent {
+    char     name[13];               // "NAME.EXT", NUL-terminated
+    uint8_t  attr;
+    uint32_t size;
+};
+
+/* A run of physically contiguous clusters backing part of a file */
+struct fat_extent {
+    uint32_t file_cluster;           // index of the first cluster within the file
+    uint32_t disk_cluster;           // its cluster number on disk
+    uint32_t count;
+};
+
+/* Mount the FAT16 volume in the first MBR partition of the ATA disk */
+int fat_mount(void);
+
+/* Paths are absolute, '/'-separated 8.3 names, matched case-insensitively.
+   All calls return a negative value on error. */
+int fat_open(const char *path);
+int fat_close(int fd);
+int fat_read(int fd, void *buf, uint32_t n);
+int fat_pread(int fd, void *buf, uint32_t n, uint32_t off);
+int fat_stat(const char *path, struct fat_stat *st);
+int fat_fstat(int fd, struct fat_stat *st);
+
+/* Fill 'out' with the idx-th entry of a directory; 1 = entry, 0 = end */
+int fat_readdir(const char *path, uint32_t idx, struct fat_dirent *out);
+
+#endif // FAT_H
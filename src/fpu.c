@@ -0,0 +1,192 @@
+// src/fpu.c
+// Lazy FPU/SSE context switching. The registers belong to at most one
+// thread at a time (the owner); every other thread runs with CR0.TS set,
+// so its first FPU or SSE instruction raises #NM and the handler swaps
+// the images. A thread that never uses the FPU is never saved or restored.
+#include <stdint.h>
+#include "fpu.h"
+#include "cpu.h"
+#include "irqstat.h"
+#include "panic.h"
+#include "proc.h"
+#include "sched.h"
+#include "terminal.h"
+
+#define CR0_MP  0x02                 // WAIT honours TS
+#define CR0_EM  0x04                 // no FPU: every FPU instruction raises #NM
+#define CR0_TS  0x08                 // task switched: next FPU/SSE use raises #NM
+#define CR0_NE  0x20                 // native x87 errors (#MF) instead of IRQ13
+#define CR4_OSFXSR     0x200
+#define CR4_OSXMMEXCPT 0x400
+
+/* simd.s */
+extern void sse2_zero_page(void *page);
+extern void sse2_copy_page(void *dst, const void *src);
+
+struct fpu_stats fpu_stats;
+
+static int fpu_present, use_fxsr, have_sse2;
+static struct thread *owner;         // whose state is in the registers
+static uint8_t clean_state[FPU_STATE_SIZE] __attribute__((aligned(16)));
+
+// --- Control registers ---
+
+static inline uint32_t read_cr0(void) {
+    uint32_t v;
+    asm volatile("mov %%cr0, %0" : "=r"(v));
+    return v;
+}
+
+static inline void write_cr0(uint32_t v) {
+    asm volatile("mov %0, %%cr0" : : "r"(v) : "memory");
+}
+
+static inline void clts(void) { asm volatile("clts" ::: "memory"); }
+static inline void stts(void) { write_cr0(read_cr0() | CR0_TS); }
+
+static void save(uint8_t *area) {
+    if (use_fxsr) asm volatile("fxsave (%0)" : : "r"(area) : "memory");
+    else          asm volatile("fnsave (%0)\n\tfwait" : : "r"(area) : "memory");
+}
+
+static void restore(const uint8_t *area) {
+    if (use_fxsr) asm volatile("fxrstor (%0)" : : "r"(area) : "memory");
+    else          asm volatile("frstor (%0)" : : "r"(area) : "memory");
+}
+
+// --- Setup ---
+
+/* Without CPUID: an FPU clears the status word on fninit, no FPU leaves it */
+static int probe_fpu(void) {
+    uint16_t sw = 0x5A5A;
+    write_cr0(read_cr0() & ~(CR0_EM | CR0_TS));
+    asm volatile("fninit\n\tfnstsw %0" : "+m"(sw));
+    return (sw & 0xFF) == 0;
+}
+
+void fpu_init(void) {
+    fpu_present = cpu_info.has_cpuid ? cpu_has(CPUID_FPU) : probe_fpu();
+    if (!fpu_present) {
+        write_cr0(read_cr0() | CR0_EM);
+        esp_printf(putc, "FPU: none, FPU instructions kill the process\r\n");
+        return;
+    }
+
+    write_cr0((read_cr0() & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE);
+    if (cpu_has(CPUID_FXSR)) {
+        uint32_t cr4;
+        asm volatile("mov %%cr4, %0" : "=r"(cr4));
+        cr4 |= CR4_OSFXSR | (cpu_has(CPUID_SSE) ? CR4_OSXMMEXCPT : 0);
+        asm volatile("mov %0, %%cr4" : : "r"(cr4));
+        use_fxsr = 1;
+    }
+    have_sse2 = use_fxsr && cpu_has(CPUID_SSE | CPUID_SSE2);
+
+    asm volatile("fninit");
+    if (cpu_has(CPUID_SSE)) {
+        uint32_t mxcsr = 0x1F80;             // all exceptions masked, round to nearest
+        asm volatile("ldmxcsr %0" : : "m"(mxcsr));
+    }
+    save(clean_state);
+    stts();
+    esp_printf(putc, "FPU: lazy %s switching%s\r\n", use_fxsr ? "fxsave" : "fnsave",
+               have_sse2 ? ", SSE2 kernel routines" : "");
+}
+
+// --- Switching ---
+
+/* Give the registers to t, parking the previous owner's state */
+static void load_for(struct thread *t) {
+    if (owner == t) return;
+    if (owner) {
+        save(owner->fpu_state);
+        fpu_stats.saves++;
+    }
+    if (t->fpu_used) {
+        restore(t->fpu_state);
+        fpu_stats.restores++;
+    } else {
+        restore(clean_state);
+        t->fpu_used = 1;
+        fpu_stats.first_uses++;
+    }
+    owner = t;
+}
+
+__attribute__((interrupt)) void fpu_nm_handler(struct interrupt_frame *frame) {
+    uint32_t t0 = irqstat_enter(7);
+    if (!fpu_present) {
+        irqstat_exit(7, t0);
+        if (frame->cs & 3) proc_kill_current(7);
+        panic("FPU instruction without an FPU at eip 0x%p", (void*)frame->eip);
+    }
+    fpu_stats.traps++;
+    clts();
+    load_for(current_thread);
+    irqstat_exit(7, t0);
+}
+
+void fpu_switch(struct thread *next) {
+    if (!fpu_present) return;
+    if (next == owner) clts();
+    else stts();
+}
+
+void fpu_release(struct thread *t) {
+    t->fpu_used = 0;
+    if (owner == t) {
+        owner = 0;
+        if (fpu_present) stts();
+    }
+}
+
+// --- Kernel SIMD ---
+
+int kernel_fpu_begin(void) {
+    if (!have_sse2) return 0;
+    clts();
+    if (owner) {
+        save(owner->fpu_state);
+        fpu_stats.saves++;
+        owner = 0;                           // restored by #NM on its next use
+    }
+    fpu_stats.kernel_uses++;
+    return 1;
+}
+
+void kernel_fpu_end(void) {
+    stts();
+}
+
+/* SSE2 for one page only pays while no thread's state is in the registers.
+   Parking it would cost a save now and a #NM plus restore on the thread's
+   next FPU instruction, more than rep stosl/movsl spend on 4KB. */
+static int page_simd_begin(void) {
+    return !owner && kernel_fpu_begin();
+}
+
+void zero_page(void *page) {
+    if (page_simd_begin()) {
+        sse2_zero_page(page);
+        kernel_fpu_end();
+        return;
+    }
+    uint32_t n = 1024;
+    asm volatile("cld\n\trep stosl" : "+D"(page), "+c"(n) : "a"(0) : "memory");
+}
+
+void copy_page(void *dst, const void *src) {
+    if (page_simd_begin()) {
+        sse2_copy_page(dst, src);
+        kernel_fpu_end();
+        return;
+    }
+    uint32_t n = 1024;
+    asm volatile("cld\n\trep movsl" : "+D"(dst), "+S"(src), "+c"(n) : : "memory");
+}
+
+void fpu_dump(func_ptr out) {
+    esp_printf(out, "fpu: %u #NM traps, %u saves, %u restores, %u first uses, %u kernel SIMD\r\n",
+               fpu_stats.traps, fpu_stats.saves, fpu_stats.restores,
+               fpu_stats.first_uses, fpu_stats.kernel_uses);
+}
@@ -0,0 +1,52 @@
+// src/fpu.h
+#ifndef FPU_H
+#define FPU_H
+
+#include <stdint.h>
+#include "interrupt.h"
+#include "rprintf.h"
+
+#define FPU_STATE_SIZE 512           // fxsave area; fnsave needs only 108 bytes
+
+struct thread;
+
+struct fpu_stats {
+    uint32_t traps;                  // #NM taken
+    uint32_t saves, restores;        // register images moved to/from a thread
+    uint32_t first_uses;             // threads handed a clean FPU
+    uint32_t kernel_uses;            // kernel_fpu_begin() brackets that used SIMD
+};
+
+extern struct fpu_stats fpu_stats;
+
+/* Set up CR0 (and CR4 for SSE), capture a clean register image and leave
+   CR0.TS set: the first FPU/SSE instruction of every thread traps to #NM,
+   which loads its state. Threads that never touch the FPU never pay for
+   a save or restore. */
+void fpu_init(void);
+
+/* #NM (vector 7) */
+__attribute__((interrupt)) void fpu_nm_handler(struct interrupt_frame *frame);
+
+/* Scheduler hook before switching to 'next': clear TS only if next's
+   state is the one in the registers */
+void fpu_switch(struct thread *next);
+
+/* Forget t's FPU state (thread exit, or a new program on the thread) */
+void fpu_release(struct thread *t);
+
+/* The kernel is built with -mgeneral-regs-only; SIMD code must sit
+   between these. begin returns 0 (and does nothing) if SSE2 is missing.
+   Kernel code is never preempted and interrupt handlers never use the
+   FPU, so the bracket only has to park the owning thread's registers. */
+int  kernel_fpu_begin(void);
+void kernel_fpu_end(void);
+
+/* 4KB-aligned page helpers: SSE2 non-temporal stores when available and
+   no thread's FPU state is loaded, rep stosl/movsl otherwise */
+void zero_page(void *page);
+void copy_page(void *dst, const void *src);
+
+void fpu_dump(func_ptr out);
+
+#endif // FPU_H
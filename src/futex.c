@@ -0,0 +1,50 @@
+// src/futex.c
+#include <stdint.h>
+#include "futex.h"
+#include "cpu.h"
+#include "page.h"
+#include "proc.h"
+#include "sched.h"
+#include "vma.h"
+
+static struct wait_queue futex_queues[FUTEX_HASH];
+
+/* Physical address of a mapped, readable word; 0 if there is none. An
+   address outside every VMA is never touched; inside one, the read
+   faults the page in like any other user access. */
+static uint32_t futex_key(uint32_t addr) {
+    if (addr & 3) return 0;
+    if (!current) return addr;                       // kernel memory is identity-mapped
+
+    struct vma *v = vma_find(&current->vmas, addr);
+    if (!v || !(v->flags & VMA_READ)) return 0;
+    (void)*(volatile uint32_t*)(uintptr_t)addr;
+    struct page *pte = mmu_lookup_pte(current->pd, addr, 0);
+    if (!pte || !pte->present) return 0;
+    return (pte->frame << 12) | (addr & 0xFFF);
+}
+
+static struct wait_queue *bucket(uint32_t key) {
+    return &futex_queues[(key >> 2) & (FUTEX_HASH - 1)];
+}
+
+int futex_wait(uint32_t addr, uint32_t val) {
+    uint32_t flags = irq_save();
+    uint32_t key = futex_key(addr);
+
+    if (!key || *(volatile uint32_t*)(uintptr_t)addr != val) {
+        irq_restore(flags);
+        return -1;
+    }
+    current_thread->wait_key = key;
+    sleep_on(bucket(key));
+    current_thread->wait_key = 0;
+    irq_restore(flags);
+    return 0;
+}
+
+int futex_wake(uint32_t addr, int n) {
+    uint32_t key = futex_key(addr);
+    if (!key || n <= 0) return 0;
+    return wake_up_key(bucket(key), key, n);
+}
@@ -0,0 +1,21 @@
+// src/futex.h
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include <stdint.h>
+
+#define FUTEX_WAIT 0
+#define FUTEX_WAKE 1
+
+#define FUTEX_HASH 16u               // wait queues, power of two
+
+/* Sleep while *addr == val. Returns 0 when woken, -1 if *addr had already
+   changed. addr is a virtual address in the current address space;
+   waiters are keyed by its physical address, so threads of different
+   processes meet on a shared frame. */
+int futex_wait(uint32_t addr, uint32_t val);
+
+/* Wake up to n threads waiting on addr; returns how many */
+int futex_wake(uint32_t addr, int n);
+
+#endif // FUTEX_H
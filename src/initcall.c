@@ -0,0 +1,83 @@
+// src/initcall.c
+// Boot steps and their cost. Every step is timed with the TSC; the
+// totals are taken from boot_tsc, read on entry to main(). Cycle counts
+// become milliseconds by comparing the TSC with the PIT tick count.
+#include <stdint.h>
+#include "cpu.h"
+#include "initcall.h"
+#include "timer.h"
+
+uint64_t boot_tsc;
+
+static const char *phase_names[INIT_NR_PHASES] = { "early", "core", "deferred" };
+
+struct step {
+    const char *name;
+    enum init_phase phase;
+    uint32_t cycles;
+};
+
+static struct step steps[INITCALL_MAX];
+static uint32_t nsteps;
+
+static uint64_t phase_end[INIT_NR_PHASES];
+static uint64_t ready_tsc;
+static uint64_t calib_tsc;                       // TSC at the first step after the PIT ticked
+static uint32_t calib_ticks;
+
+void initcall_run(const struct initcall *calls, uint32_t n, enum init_phase phase) {
+    for (uint32_t i = 0; i < n; ++i) {
+        if (calls[i].phase != phase) continue;
+        uint64_t t0 = rdtsc();
+        calls[i].fn();
+        uint64_t t1 = rdtsc();
+        if (nsteps < INITCALL_MAX)
+            steps[nsteps++] = (struct step){ calls[i].name, phase, (uint32_t)(t1 - t0) };
+        if (!calib_tsc && ticks) {
+            calib_tsc = t1;
+            calib_ticks = ticks;
+        }
+    }
+    phase_end[phase] = rdtsc();
+}
+
+void initcall_ready(void) {
+    ready_tsc = rdtsc();
+}
+
+/* 1024-cycle units per millisecond, i.e. kcycles * TIMER_HZ / (1000 * ticks),
+   with the ticks turned into milliseconds first so nothing overflows;
+   0 if less than a millisecond has been measured */
+static uint32_t kcycles_per_ms(void) {
+    uint32_t t = ticks - calib_ticks;
+    uint32_t ms = t / TIMER_HZ * 1000u + t % TIMER_HZ * 1000u / TIMER_HZ;
+    if (!calib_tsc || !ms) return 0;
+    return (uint32_t)((rdtsc() - calib_tsc) >> 10) / ms;
+}
+
+static void since_boot(func_ptr out, const char *what, uint64_t tsc, uint32_t kpm) {
+    if (!tsc) return;
+    uint32_t k = (uint32_t)((tsc - boot_tsc) >> 10);
+    if (kpm)
+        esp_printf(out, "boot: %-8s %8u Kcycles  %u.%u ms\r\n", what, k,
+                   k / kpm, (k % kpm) * 10u / kpm);
+    else
+        esp_printf(out, "boot: %-8s %8u Kcycles\r\n", what, k);
+}
+
+void initcall_report(func_ptr out) {
+    if (!boot_tsc) {
+        esp_printf(out, "boot: no TSC, steps not timed\r\n");
+        return;
+    }
+    uint32_t kpm = kcycles_per_ms();
+
+    esp_printf(out, "boot: %-12s %-9s %10s\r\n", "step", "phase", "cycles");
+    for (uint32_t i = 0; i < nsteps; ++i)
+        esp_printf(out, "boot: %-12s %-9s %10u\r\n", steps[i].name,
+                   phase_names[steps[i].phase], steps[i].cycles);
+    esp_printf(out, "boot: time from handoff to ready and to the end of each phase\r\n");
+    since_boot(out, "ready", ready_tsc, kpm);
+    for (int p = 0; p < INIT_NR_PHASES; ++p)
+        since_boot(out, phase_names[p], phase_end[p], kpm);
+}
@@ -0,0 +1,41 @@
+// src/initcall.h
+#ifndef INITCALL_H
+#define INITCALL_H
+
+#include <stdint.h>
+#include "rprintf.h"
+
+/* Boot is a table of named steps run phase by phase. INIT_EARLY and
+   INIT_CORE run on the boot stack in main(); INIT_DEFERRED runs on the
+   init thread once the scheduler is up, so the console already takes
+   input while the disk is probed and mounted. */
+enum init_phase {
+    INIT_EARLY,                      // console: nothing before it can print
+    INIT_CORE,                       // CPU, interrupts, scheduler, memory, paging
+    INIT_DEFERRED,                   // devices and filesystems, on the init thread
+    INIT_NR_PHASES
+};
+
+struct initcall {
+    const char *name;
+    void (*fn)(void);
+    enum init_phase phase;
+};
+
+#define INITCALL_MAX 32u             // steps whose time is kept for the report
+
+/* TSC at main() entry, as close to the bootloader handoff as it can be read */
+extern uint64_t boot_tsc;
+
+/* Run the entries of 'calls' that belong to 'phase', in table order,
+   timing each with rdtsc() */
+void initcall_run(const struct initcall *calls, uint32_t n, enum init_phase phase);
+
+/* The console takes input from here on */
+void initcall_ready(void);
+
+/* Cycles per step, then the time from handoff to ready and to the end of
+   each phase (milliseconds once the PIT has ticked) */
+void initcall_report(func_ptr out);
+
+#endif // INITCALL_H
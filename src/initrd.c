@@ -0,0 +1,101 @@
+// src/initrd.c
+// In-memory filesystem over a ustar archive loaded as a Multiboot module.
+// Mounting walks the 512-byte headers once and records where each file's
+// data starts; lookups and reads only ever hand out pointers into the
+// module, so the archive is the page cache.
+#include <stdint.h>
+#include "initrd.h"
+#include "kstring.h"
+
+#define TAR_BLOCK       512u
+#define TAR_NAME        0            // char name[100]
+#define TAR_SIZE        124          // char size[12], octal
+#define TAR_TYPE        156          // '0' or NUL = regular file
+#define TAR_MAGIC       257          // "ustar"
+#define TAR_PREFIX      345          // char prefix[155]; unused, names stay short
+
+static struct initrd_file files[INITRD_MAX_FILES];
+static uint32_t nfiles;
+
+static uint32_t octal(const uint8_t *p, uint32_t len) {
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < len && p[i] >= '0' && p[i] <= '7'; ++i)
+        v = (v << 3) | (p[i] - '0');
+    return v;
+}
+
+/* Strip the "./" or "/" that tar and callers may put in front */
+static const char *skip_root(const char *s, uint32_t *len) {
+    while (*len && (s[0] == '/' || (s[0] == '.' && *len > 1 && s[1] == '/'))) {
+        uint32_t k = (s[0] == '/') ? 1 : 2;
+        s += k;
+        *len -= k;
+    }
+    return s;
+}
+
+int initrd_mount(const void *base, uint32_t len) {
+    const uint8_t *p = (const uint8_t*)base;
+    uint32_t off = 0;
+
+    nfiles = 0;
+    if (len < TAR_BLOCK || memcmp(p + TAR_MAGIC, "ustar", 5) != 0)
+        return -1;
+
+    while (off + TAR_BLOCK <= len) {
+        const uint8_t *h = p + off;
+        if (h[TAR_NAME] == 0)                      // end-of-archive marker
+            break;
+        if (memcmp(h + TAR_MAGIC, "ustar", 5) != 0)
+            return -1;
+
+        uint32_t size = octal(h + TAR_SIZE, 12);
+        uint32_t data = off + TAR_BLOCK;
+        if (size > len - data)
+            return -1;
+
+        uint32_t name_len = 0;
+        while (name_len < 100 && h[TAR_NAME + name_len]) name_len++;
+        const char *name = skip_root((const char*)h + TAR_NAME, &name_len);
+
+        if ((h[TAR_TYPE] == '0' || h[TAR_TYPE] == 0) && name_len && nfiles < INITRD_MAX_FILES) {
+            struct initrd_file *f = &files[nfiles++];
+            f->name     = name;
+            f->name_len = name_len;
+            f->data     = p + data;
+            f->size     = size;
+        }
+        off = data + ((size + TAR_BLOCK - 1) & ~(TAR_BLOCK - 1));
+    }
+    return (int)nfiles;
+}
+
+int initrd_lookup(const char *path, struct initrd_file *out) {
+    uint32_t len = 0;
+    while (path[len]) len++;
+    path = skip_root(path, &len);
+
+    for (uint32_t i = 0; i < nfiles; ++i) {
+        if (files[i].name_len == len && memcmp(files[i].name, path, len) == 0) {
+            *out = files[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+uint32_t initrd_read(const struct initrd_file *f, uint32_t off, uint32_t n, const void **ptr) {
+    if (off >= f->size) {
+        *ptr = f->data + f->size;
+        return 0;
+    }
+    if (n > f->size - off) n = f->size - off;
+    *ptr = f->data + off;
+    return n;
+}
+
+int initrd_readdir(uint32_t idx, struct initrd_file *out) {
+    if (idx >= nfiles) return 0;
+    *out = files[idx];
+    return 1;
+}
@@ -0,0 +1,32 @@
+// src/initrd.h
+#ifndef INITRD_H
+#define INITRD_H
+
+#include <stdint.h>
+
+#define INITRD_MAX_FILES 64
+
+/* A regular file in the initrd. 'data' points straight into the module. */
+struct initrd_file {
+    const char    *name;             // path inside the archive, without "./"
+    uint32_t       name_len;
+    const uint8_t *data;
+    uint32_t       size;
+};
+
+/* Index a ustar archive held in memory at [base, base+len). Nothing is
+   copied; the archive must stay mapped and unmodified while in use.
+   Returns the number of files, or -1 if it is not a ustar archive. */
+int initrd_mount(const void *base, uint32_t len);
+
+/* Absolute or relative path, matched exactly. 0 on success, -1 if absent. */
+int initrd_lookup(const char *path, struct initrd_file *out);
+
+/* Zero-copy read: point *ptr at offset 'off' of the file and return how
+   many bytes are available there (at most n, 0 at end of file). */
+uint32_t initrd_read(const struct initrd_file *f, uint32_t off, uint32_t n, const void **ptr);
+
+/* Fill 'out' with the idx-th file; 1 = entry, 0 = end */
+int initrd_readdir(uint32_t idx, struct initrd_file *out);
+
+#endif // INITRD_H
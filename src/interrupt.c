@@ -5,10 +5,17 @@
 
 #include <stdint.h>
 #include "interrupt.h"
+#include "fpu.h"
+#include "irqstat.h"
+#include "proc.h"
+#include "syscall.h"
+#include "panic.h"
 
 // Forward declarations
 extern void keyboard_handler(struct interrupt_frame* frame);
-struct process_context_with_error;
+extern void pit_handler(struct interrupt_frame* frame);
+extern void syscall_entry(void);       // isr.s
+extern void page_fault_entry(void);    // isr.s
 
 // ---------------- I/O Helpers ----------------
 void outb(uint16_t _port, uint8_t val) {
@@ -21,6 +28,26 @@ uint8_t inb(uint16_t _port) {
     return ret;
 }
 
+void outw(uint16_t _port, uint16_t val) {
+    __asm__ __volatile__("outw %0, %1" : : "a"(val), "dN"(_port));
+}
+
+uint16_t inw(uint16_t _port) {
+    uint16_t ret;
+    __asm__ __volatile__("inw %1, %0" : "=a"(ret) : "dN"(_port));
+    return ret;
+}
+
+void outl(uint16_t _port, uint32_t val) {
+    __asm__ __volatile__("outl %0, %1" : : "a"(val), "dN"(_port));
+}
+
+uint32_t inl(uint16_t _port) {
+    uint32_t ret;
+    __asm__ __volatile__("inl %1, %0" : "=a"(ret) : "dN"(_port));
+    return ret;
+}
+
 // ---------------- Memory ----------------
 void memset(char *s, char c, unsigned int n) {
     for (unsigned int k = 0; k < n; k++) s[k] = c;
@@ -72,17 +99,17 @@ void load_gdt() {
         "lgdt [gdt_desc]\n"
         "ljmp $0x8,$gdt_flush\n"
         "gdt_flush:\n"
-        "mov %%eax, 0x10\n"
-        "mov %%ds, %%eax\n"
-        "mov %%ss, %%eax\n"
-        "mov %%es, %%eax\n"
-        "mov %%fs, %%eax\n"
-        "mov %%gs, %%eax\n" : : : "eax");
+        "mov $0x10, %%ax\n"
+        "mov %%ax, %%ds\n"
+        "mov %%ax, %%ss\n"
+        "mov %%ax, %%es\n"
+        "mov %%ax, %%fs\n"
+        "mov %%ax, %%gs\n" : : : "eax");
 }
 
 void write_tss(struct gdt_entry_bits *g) {
     uint32_t base = (uint32_t)&tss_ent;
-    uint32_t limit = base + sizeof(struct tss_entry);
+    uint32_t limit = sizeof(struct tss_entry) - 1;
 
     g->limit_low = limit & 0xFFFF;
     g->base_low = base & 0xFFFFFF;
@@ -107,6 +134,23 @@ void PIC_sendEOI(unsigned char irq) {
     outb(PIC_1_COMMAND, PIC_EOI);
 }
 
+static uint8_t pic_isr(uint16_t command) {
+    outb(command, PIC_READ_ISR);
+    return inb(command);
+}
+
+/* Acknowledge an unclaimed IRQ. IRQ7 and IRQ15 with their ISR bit clear
+   are spurious: the PIC raised nothing, so the master gets no EOI for
+   IRQ7, and for IRQ15 only the master gets one (for the cascade on IRQ2) */
+static void PIC_ackUnclaimed(unsigned char irq) {
+    if (irq == 7 && !(pic_isr(PIC_1_COMMAND) & 0x80)) return;
+    if (irq == 15 && !(pic_isr(PIC_2_COMMAND) & 0x80)) {
+        outb(PIC_1_COMMAND, PIC_EOI);
+        return;
+    }
+    PIC_sendEOI(irq);
+}
+
 void IRQ_set_mask(unsigned char IRQline) {
     uint16_t port = (IRQline < 8) ? PIC_1_DATA : PIC_2_DATA;
     if (IRQline >= 8) IRQline -= 8;
@@ -138,14 +182,62 @@ void remap_pic(void) {
 // ---------------- IDT ----------------
 void idt_flush(struct idt_ptr *idt) { asm("lidt %0" : : "m"(*idt)); }
 
-__attribute__((interrupt)) void divide_error_handler(struct interrupt_frame* frame){ asm("cli"); while(1); }
-__attribute__((interrupt)) void stub_isr(struct interrupt_frame* frame){ asm("cli"); while(1); }
-__attribute__((interrupt)) void pit_handler(struct interrupt_frame* frame){ asm("cli"); while(1); }
-__attribute__((interrupt)) void syscall_handler(struct interrupt_frame* frame){ asm("cli"); while(1); }
-void general_protection_handler(struct interrupt_frame* frame){ asm("cli"); while(1); }
-void page_fault_handler(struct process_context_with_error* ctx){ asm("cli"); while(1); }
+__attribute__((interrupt)) void divide_error_handler(struct interrupt_frame* frame){ irqstat_exit(0, irqstat_enter(0)); if (frame->cs & 3) proc_kill_current(0); panic("divide error at eip 0x%p", (void*)frame->eip); }
+__attribute__((interrupt)) void stub_isr(struct interrupt_frame* frame){ irqstat[cpu_id()].unknown++; panic("unexpected interrupt at eip 0x%p", (void*)frame->eip); }
+
+/* Traps that need the full register frame come here from isr.s */
+void trap_dispatch(struct trapframe *tf) {
+    uint32_t t0 = irqstat_enter(tf->vector);
+    if (tf->vector == 0x80)
+        syscall_dispatch(tf);
+    else
+        proc_page_fault(tf);
+    irqstat_exit(tf->vector, t0);
+}
+
+/* Per-vector stubs so irqstat can tell exceptions and IRQ lines apart.
+   Exceptions in ring 3 kill the process; in the kernel they panic.
+   Unclaimed IRQs are acknowledged (spurious IRQ7/15 excepted) and counted
+   so an interrupt storm shows up in the dump instead of wedging the machine. */
+#define EXC_STUB(n) \
+    __attribute__((interrupt)) static void exc_stub_##n(struct interrupt_frame* frame) \
+    { irqstat_exit(n, irqstat_enter(n)); if (frame->cs & 3) proc_kill_current(n); \
+      panic("exception %d at eip 0x%p", n, (void*)frame->eip); }
+#define EXC_STUB_ERR(n) \
+    __attribute__((interrupt)) static void exc_stub_##n(struct interrupt_frame* frame, uint32_t errcode) \
+    { irqstat_exit(n, irqstat_enter(n)); if (frame->cs & 3) proc_kill_current(n); \
+      panic("exception %d (error %x) at eip 0x%p", n, errcode, (void*)frame->eip); }
+#define IRQ_STUB(n) \
+    __attribute__((interrupt)) static void irq_stub_##n(struct interrupt_frame* frame) \
+    { uint32_t t0 = irqstat_enter(32 + n); PIC_ackUnclaimed(n); irqstat_exit(32 + n, t0); }
+
+EXC_STUB(0)      EXC_STUB(1)      EXC_STUB(2)      EXC_STUB(3)
+EXC_STUB(4)      EXC_STUB(5)      EXC_STUB(6)      EXC_STUB(7)
+EXC_STUB_ERR(8)  EXC_STUB(9)      EXC_STUB_ERR(10) EXC_STUB_ERR(11)
+EXC_STUB_ERR(12) EXC_STUB_ERR(13) EXC_STUB_ERR(14) EXC_STUB(15)
+EXC_STUB(16)     EXC_STUB_ERR(17) EXC_STUB(18)     EXC_STUB(19)
+EXC_STUB(20)     EXC_STUB_ERR(21) EXC_STUB(22)     EXC_STUB(23)
+EXC_STUB(24)     EXC_STUB(25)     EXC_STUB(26)     EXC_STUB(27)
+EXC_STUB(28)     EXC_STUB_ERR(29) EXC_STUB_ERR(30) EXC_STUB(31)
+
+IRQ_STUB(0)  IRQ_STUB(1)  IRQ_STUB(2)  IRQ_STUB(3)
+IRQ_STUB(4)  IRQ_STUB(5)  IRQ_STUB(6)  IRQ_STUB(7)
+IRQ_STUB(8)  IRQ_STUB(9)  IRQ_STUB(10) IRQ_STUB(11)
+IRQ_STUB(12) IRQ_STUB(13) IRQ_STUB(14) IRQ_STUB(15)
+
+static void *const exc_stubs[32] = {
+    exc_stub_0,  exc_stub_1,  exc_stub_2,  exc_stub_3,  exc_stub_4,  exc_stub_5,  exc_stub_6,  exc_stub_7,
+    exc_stub_8,  exc_stub_9,  exc_stub_10, exc_stub_11, exc_stub_12, exc_stub_13, exc_stub_14, exc_stub_15,
+    exc_stub_16, exc_stub_17, exc_stub_18, exc_stub_19, exc_stub_20, exc_stub_21, exc_stub_22, exc_stub_23,
+    exc_stub_24, exc_stub_25, exc_stub_26, exc_stub_27, exc_stub_28, exc_stub_29, exc_stub_30, exc_stub_31
+};
+
+static void *const irq_stubs[16] = {
+    irq_stub_0,  irq_stub_1,  irq_stub_2,  irq_stub_3,  irq_stub_4,  irq_stub_5,  irq_stub_6,  irq_stub_7,
+    irq_stub_8,  irq_stub_9,  irq_stub_10, irq_stub_11, irq_stub_12, irq_stub_13, irq_stub_14, irq_stub_15
+};
 
-static void idt_set_gate(uint8_t num, uint32_t base, uint16_t sel, uint8_t flags) {
+void idt_set_gate(uint8_t num, uint32_t base, uint16_t sel, uint8_t flags) {
     idt_entries[num].base_lo = base & 0xFFFF;
     idt_entries[num].base_hi = (base >> 16) & 0xFFFF;
     idt_entries[num].sel     = sel;
@@ -163,10 +255,16 @@ void init_idt() {
 
     for (int i = 0; i < 256; i++)
         idt_set_gate(i, (uint32_t)stub_isr, 0x08, 0x8E);
+    for (int i = 0; i < 32; i++)
+        idt_set_gate(i, (uint32_t)exc_stubs[i], 0x08, 0x8E);
+    for (int i = 0; i < 16; i++)
+        idt_set_gate(32 + i, (uint32_t)irq_stubs[i], 0x08, 0x8E);
 
     idt_set_gate(0, (uint32_t)divide_error_handler, 0x08, 0x8E);
     idt_set_gate(0x21, (uint32_t)keyboard_handler, 0x08, 0x8E);
-    idt_set_gate(0x80, (uint32_t)syscall_handler,  0x08, 0xEE);
+    idt_set_gate(7,    (uint32_t)fpu_nm_handler,   0x08, 0x8E);
+    idt_set_gate(14,   (uint32_t)page_fault_entry, 0x08, 0x8E);
+    idt_set_gate(0x80, (uint32_t)syscall_entry,    0x08, 0xEE);
     idt_set_gate(32,   (uint32_t)pit_handler,      0x08, 0x8E);
 
     idt_flush(&idt_ptr);
@@ -5,6 +5,7 @@
 
 /* ---- PIC constants ---- */
 #define PIC_EOI         0x20       // End-of-interrupt command code
+#define PIC_READ_ISR    0x0B       // OCW3: next read of the command port returns the ISR
 #define PIC1            0x20       // IO base address for master PIC
 #define PIC2            0xA0       // IO base address for slave PIC
 #define PIC_1_COMMAND   PIC1
@@ -121,10 +122,17 @@ struct gdt_entry_bits {
 } __attribute__((packed));
 
 /* ---- Function prototypes ---- */
+uint8_t  inb(uint16_t _port);
+void     outb(uint16_t _port, uint8_t val);
+uint16_t inw(uint16_t _port);
+void     outw(uint16_t _port, uint16_t val);
+uint32_t inl(uint16_t _port);
+void     outl(uint16_t _port, uint32_t val);
 void PIC_sendEOI(unsigned char irq);
 void IRQ_clear_mask(unsigned char IRQline);
 void IRQ_set_mask(unsigned char IRQline);
 void init_idt(void);
+void idt_set_gate(uint8_t num, uint32_t base, uint16_t sel, uint8_t flags);
 void tss_flush(uint16_t tss);
 void load_gdt(void);
 void remap_pic(void);
@@ -0,0 +1,47 @@
+// src/irqstat.c
+#include <stdint.h>
+#include "irqstat.h"
+
+struct irqstat_cpu irqstat[MAX_CPUS];
+
+static inline uint32_t log2_bucket(uint32_t cycles) {
+    if (cycles == 0) return 0;
+    uint32_t b = 31u - (uint32_t)__builtin_clz(cycles);
+    return (b < IRQSTAT_BUCKETS) ? b : IRQSTAT_BUCKETS - 1;
+}
+
+/* Runs with interrupts off (all our gates are interrupt gates), so the
+   per-CPU slot cannot be torn by a nested handler. */
+void irqstat_exit(uint8_t vector, uint32_t t0) {
+    struct irqstat_cpu *s = &irqstat[cpu_id()];
+    uint32_t dt = (uint32_t)rdtsc() - t0;
+
+    s->count[vector]++;
+    if (dt > s->max_cycles[vector]) s->max_cycles[vector] = dt;
+    s->hist[vector][log2_bucket(dt)]++;
+    TRACE(TR_IRQ_EXIT, vector, dt, 0);
+}
+
+void irqstat_reset(void) {
+    for (int c = 0; c < MAX_CPUS; ++c) {
+        uint32_t *w = (uint32_t*)&irqstat[c];
+        for (uint32_t i = 0; i < sizeof(irqstat[c]) / 4u; ++i) w[i] = 0;
+    }
+}
+
+void irqstat_dump(func_ptr out) {
+    for (int c = 0; c < MAX_CPUS; ++c) {
+        struct irqstat_cpu *s = &irqstat[c];
+        esp_printf(out, "--- irqstat cpu%d (unknown vectors: %u) ---\r\n", c, s->unknown);
+
+        for (int v = 0; v < IRQSTAT_VECTORS; ++v) {
+            if (!s->count[v]) continue;
+            esp_printf(out, "vec 0x%02x count=%u max=%ucyc\r\n ",
+                       v, s->count[v], s->max_cycles[v]);
+            for (int b = 0; b < IRQSTAT_BUCKETS; ++b)
+                if (s->hist[v][b])
+                    esp_printf(out, " 2^%d:%u", b, s->hist[v][b]);
+            esp_printf(out, "\r\n");
+        }
+    }
+}
@@ -0,0 +1,36 @@
+// src/irqstat.h
+#ifndef IRQSTAT_H
+#define IRQSTAT_H
+
+#include <stdint.h>
+#include "cpu.h"
+#include "rprintf.h"
+#include "trace.h"
+
+/* Handler durations are bucketed by floor(log2(cycles)); the last bucket
+   collects everything at or above 2^(IRQSTAT_BUCKETS-1) cycles. */
+#define IRQSTAT_VECTORS 256
+#define IRQSTAT_BUCKETS 24
+
+struct irqstat_cpu {
+    uint32_t count[IRQSTAT_VECTORS];
+    uint32_t max_cycles[IRQSTAT_VECTORS];
+    uint32_t hist[IRQSTAT_VECTORS][IRQSTAT_BUCKETS];
+    uint32_t unknown;            // vectors that landed in the generic stub
+};
+
+extern struct irqstat_cpu irqstat[MAX_CPUS];
+
+/* Call at handler entry; pass the result to irqstat_exit() */
+static inline uint32_t irqstat_enter(uint8_t vector) {
+    TRACE(TR_IRQ_ENTER, vector, 0, 0);
+    return (uint32_t)rdtsc();
+}
+
+void irqstat_exit(uint8_t vector, uint32_t t0);
+void irqstat_reset(void);
+
+/* Print every vector that fired, with its log2 latency histogram */
+void irqstat_dump(func_ptr out);
+
+#endif // IRQSTAT_H
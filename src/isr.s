@@ -0,0 +1,118 @@
+# src/isr.s — trap entry points that need the full register frame, and the
+# ring 0 <-> ring 3 transitions used by proc.c
+#
+# Stack layout built by trap_common matches struct trapframe in proc.h.
+
+.section .text
+
+.global syscall_entry
+.type syscall_entry, @function
+syscall_entry:
+    push $0             # no error code for int $0x80
+    push $0x80
+    jmp trap_common
+
+.global page_fault_entry
+.type page_fault_entry, @function
+page_fault_entry:
+    push $14            # the CPU already pushed the error code
+    jmp trap_common
+
+trap_common:
+    pusha
+    push %ds
+    push %es
+    push %fs
+    push %gs
+    mov $0x10, %ax
+    mov %ax, %ds
+    mov %ax, %es
+    mov %ax, %fs
+    mov %ax, %gs
+    push %esp           # struct trapframe *
+    call trap_dispatch
+    add $4, %esp
+    pop %gs
+    pop %fs
+    pop %es
+    pop %ds
+    popa
+    add $8, %esp        # vector, error code
+    iret
+
+# void switch_to(uint32_t *save_esp, uint32_t esp)
+# Save the callee-saved registers on this thread's stack, then resume the
+# thread whose stack pointer is 'esp' where it last called switch_to().
+.global switch_to
+.type switch_to, @function
+switch_to:
+    mov 4(%esp), %eax
+    mov 8(%esp), %edx
+    push %ebp
+    push %ebx
+    push %esi
+    push %edi
+    mov %esp, (%eax)
+    mov %edx, %esp
+    pop %edi
+    pop %esi
+    pop %ebx
+    pop %ebp
+    ret
+
+# First return of a new thread (see thread_create): fn and arg are on the
+# stack. Interrupts were off across switch_to().
+.global thread_start
+.type thread_start, @function
+thread_start:
+    sti
+    pop %eax            # fn; arg is now its first argument
+    call *%eax
+    call thread_exit
+
+# int user_enter(uint32_t eip, uint32_t esp, uint32_t *kesp)
+# Save the kernel context, then iret to ring 3. Returns the value passed
+# to user_return() once the process exits or is killed.
+.global user_enter
+.type user_enter, @function
+user_enter:
+    push %ebp
+    push %ebx
+    push %esi
+    push %edi
+    pushf
+    mov 24(%esp), %eax  # eip
+    mov 28(%esp), %ecx  # user esp
+    mov 32(%esp), %edx  # kesp
+    mov %esp, (%edx)
+    mov %esp, tss_ent+4 # traps from ring 3 land below the saved context
+    mov $0x23, %bx      # user data selector, RPL 3
+    mov %bx, %ds
+    mov %bx, %es
+    mov %bx, %fs
+    mov %bx, %gs
+    push $0x23          # ss
+    push %ecx           # esp
+    push $0x202         # eflags: IF
+    push $0x1B          # cs: user code, RPL 3
+    push %eax           # eip
+    iret
+
+# void user_return(uint32_t kesp, int code)
+# Abandon the trap stack and return from user_enter() with 'code'.
+.global user_return
+.type user_return, @function
+user_return:
+    mov 8(%esp), %eax
+    mov 4(%esp), %esp
+    mov $0x10, %bx
+    mov %bx, %ds
+    mov %bx, %es
+    mov %bx, %fs
+    mov %bx, %gs
+    popf
+    pop %edi
+    pop %esi
+    pop %ebx
+    pop %ebp
+    ret
@@ -5,6 +5,25 @@
 #include "interrupt.h"
 #include "scancodes.h"
 #include "page.h"
+#include "serial.h"
+#include "irqstat.h"
+#include "keyboard.h"
+#include "trace.h"
+#include "timer.h"
+#include "prof.h"
+#include "bench.h"
+#include "ata.h"
+#include "bcache.h"
+#include "fat.h"
+#include "proc.h"
+#include "multiboot.h"
+#include "initrd.h"
+#include "sched.h"
+#include "cpu.h"
+#include "kstring.h"
+#include "fpu.h"
+#include "swap.h"
+#include "initcall.h"
 
 #undef putc
 extern int putc(int);
@@ -27,64 +46,188 @@ static inline void build_single_ppage(struct ppage *node, uint32_t phys) {
     node->next = 0;
 }
 
-void main(void) {
-    terminal_init();
+/* What GRUB handed to _start */
+static uint32_t boot_magic, boot_mbi;
+
+/* The first Multiboot module, if any, mounted as the initrd */
+static uint32_t initrd_start, initrd_end;
+
+/* GRUB places modules just past the kernel, i.e. inside the frame pool, so
+   every module's frames are reserved before anything can allocate them.
+   Runs before paging: the info structure is wherever GRUB left it. */
+static void boot_modules(uint32_t magic, uint32_t mbi_addr) {
+    if (magic != MULTIBOOT_BOOTLOADER_MAGIC) {
+        esp_printf(putc, "No multiboot info (magic 0x%x)\r\n", magic);
+        return;
+    }
+    struct multiboot_info *mbi = (struct multiboot_info*)(uintptr_t)mbi_addr;
+    if (!(mbi->flags & MULTIBOOT_INFO_MODS) || mbi->mods_count == 0)
+        return;
+
+    struct multiboot_module *mod = (struct multiboot_module*)(uintptr_t)mbi->mods_addr;
+    for (uint32_t i = 0; i < mbi->mods_count; ++i)
+        pfa_reserve(mod[i].mod_start, mod[i].mod_end);
+
+    initrd_start = mod[0].mod_start;
+    initrd_end   = mod[0].mod_end;
+    int n = initrd_mount((const void*)(uintptr_t)initrd_start, initrd_end - initrd_start);
+    if (n < 0)
+        esp_printf(putc, "initrd: module at 0x%p is not a ustar archive\r\n", (void*)initrd_start);
+    else
+        esp_printf(putc, "initrd: %d files at 0x%p - 0x%p\r\n", n, (void*)initrd_start, (void*)initrd_end);
+}
+
+/* User programs in turn: from the initrd when there is one, else the disk */
+static const char *init_progs[] = { "/hello", "/memtest", "/swaptest", "/fputest", 0 };
+
+static void init_deferred(void);
+
+static void init_thread(void *arg) {
+    init_deferred();
+    for (const char **path = arg; *path; ++path)
+        proc_exec(*path);
+}
+
+/* Echo the keyboard; sleeps in kbd_getc() until the IRQ hands it a key */
+static void console_thread(void *arg) {
+    while (1)
+        putc(kbd_getc());
+}
+
+/* Debug hotkeys, handled outside interrupt context */
+static void diag_thread(void *arg) {
+    while (1) {
+        uint32_t keys = kbd_wait_hotkeys();
+        if (keys & HOTKEY_IRQSTAT) {
+            irqstat_dump(putc);
+            irqstat_dump(serial_putc);
+            sched_dump(putc);
+            swap_dump(putc);
+            fpu_dump(putc);
+            initcall_report(putc);
+        }
+        if (keys & HOTKEY_TRACE_ON) {
+            trace_enable(!trace_enabled);
+            esp_printf(putc, "Tracing %s.\r\n", trace_enabled ? "on" : "off");
+        }
+        if (keys & HOTKEY_TRACE) {
+            trace_dump(serial_putc);
+            esp_printf(putc, "Trace dumped to COM1.\r\n");
+        }
+        if (keys & HOTKEY_PROF) {
+            prof_dump(serial_putc);
+            esp_printf(putc, "Profile dumped to COM1.\r\n");
+        }
+    }
+}
+
+// --- Boot steps ---
+
+static void boot_banner(void) {
     esp_printf(putc, "Hello from CS310 kernel!\r\n");
     esp_printf(putc, "CPL = %d\r\n", current_cpl());
+    cpu_dump(putc);
+}
+
+static void boot_cpu(void) {
+    mmu_select_cpu();
+    kstring_select_cpu();
+}
 
-    /* HW2: interrupts on (kept from your previous work) */
-    remap_pic();
-    load_gdt();
-    init_idt();
+static void boot_timer(void) {
+    timer_init(TIMER_HZ);
     asm("sti");
     esp_printf(putc, "Interrupts initialized.\r\n");
+}
 
-    /* ---------------------- HW4: Paging ---------------------- */
-    mmu_init();
-
-    /* Identity-map:
-       (a) kernel [0x00100000 .. &_end_kernel)
-       (b) current stack pages
-       (c) VGA text buffer @ 0x000B8000
-     */
+static void boot_pfa(void) {
+    pfa_init();
+    boot_modules(boot_magic, boot_mbi);
+}
 
-    /* (a) Kernel binary range */
-    const uint32_t K_START = 0x00100000u;
-    const uint32_t K_END   = align_up((uint32_t)(uintptr_t)&_end_kernel, 4096);
+/* pd already identity-maps the kernel, VGA and the frame pool (boot_pt.S),
+   so only an initrd GRUB put past BOOT_MAP_END needs PTEs here */
+static void boot_paging(void) {
     struct ppage tmp;
 
-    for (uint32_t pa = K_START; pa < K_END; pa += 4096) {
+    mmu_init();
+    uint32_t pa = align_down(initrd_start, 4096);
+    if (pa < BOOT_MAP_END) pa = BOOT_MAP_END;
+    for (; pa < initrd_end; pa += 4096) {
         build_single_ppage(&tmp, pa);
-        map_pages((void*)pa, &tmp, pd);   // identity: VA == PA
+        map_pages_flags((void*)pa, &tmp, pd, PTE_W | PTE_G);
     }
-    esp_printf(putc, "Mapped kernel: 0x%p - 0x%p\r\n", (void*)K_START, (void*)K_END);
 
-    /* (b) Stack: grab ESP and map 16KB (4 pages) around it, identity */
-    uint32_t esp_val;
-    asm volatile("mov %%esp, %0" : "=r"(esp_val));
-    uint32_t esp_page = align_down(esp_val, 4096);
-    const int STACK_PAGES = 4; // your start.s created 16KB stack
+    /* Load CR3 with PD and enable paging */
+    loadPageDirectory(pd);
+    enable_paging();
+    mmu_enable_global();
+    esp_printf(putc, "Paging enabled: kernel, VGA and frame pool 0x%p - 0x%p identity-mapped\r\n",
+               (void*)pfa_base(), (void*)(pfa_base() + pfa_total_count() * 4096u));
+}
 
-    for (int i = 0; i < STACK_PAGES; ++i) {
-        uint32_t pa = esp_page - (uint32_t)i * 4096u;
-        build_single_ppage(&tmp, pa);
-        map_pages((void*)pa, &tmp, pd);
+/* Boot disk: ATA driver under the block buffer cache */
+static void boot_disk(void) {
+    if (ata_init() != 0)
+        esp_printf(putc, "ATA: no disk on primary master\r\n");
+    else if (fat_mount() == 0) {
+        struct fat_stat st;
+        if (fat_stat("/kernel", &st) == 0)
+            esp_printf(putc, "FAT16: /kernel is %u bytes\r\n", st.size);
     }
-    esp_printf(putc, "Mapped stack around ESP=0x%p\r\n", (void*)esp_val);
+}
 
-    /* (c) VGA buffer (0xB8000) — exactly one page and already 4KB-aligned */
-    build_single_ppage(&tmp, 0x000B8000u);
-    map_pages((void*)0x000B8000u, &tmp, pd);
-    esp_printf(putc, "Mapped VGA buffer @ 0xB8000\r\n");
+static void boot_swap(void) {
+    swap_init();
+}
 
-    /* Load CR3 with PD and enable paging */
-    loadPageDirectory(pd);
-    enable_paging();
-    esp_printf(putc, "Paging enabled (CR3=PD, CR0.PG set).\r\n");
+/* In order within a phase. Nothing in INIT_CORE may need the disk: the
+   initrd is mounted in place and proc_exec() only runs on the init thread. */
+static const struct initcall boot_calls[] = {
+    { "terminal",  terminal_init, INIT_EARLY },
+    { "serial",    serial_init,   INIT_EARLY },
+    { "banner",    boot_banner,   INIT_EARLY },
+    { "pic",       remap_pic,     INIT_CORE },
+    { "gdt",       load_gdt,      INIT_CORE },
+    { "idt",       init_idt,      INIT_CORE },
+    { "cpu",       boot_cpu,      INIT_CORE },
+    { "fpu",       fpu_init,      INIT_CORE },
+    { "sched",     sched_init,    INIT_CORE },
+    { "timer",     boot_timer,    INIT_CORE },
+    { "pfa",       boot_pfa,      INIT_CORE },
+    { "paging",    boot_paging,   INIT_CORE },
+    { "bcache",    bcache_init,   INIT_DEFERRED },
+    { "disk",      boot_disk,     INIT_DEFERRED },
+    { "swap",      boot_swap,     INIT_DEFERRED },
+};
+#define NBOOT_CALLS (sizeof(boot_calls) / sizeof(boot_calls[0]))
 
-    /* If you get a triple fault/reset right after this point, your PD/PT entries are wrong. */
+/* Devices come up on the init thread, before it runs the first program */
+static void init_deferred(void) {
+    initcall_run(boot_calls, NBOOT_CALLS, INIT_DEFERRED);
+    initcall_report(serial_putc);
+}
 
-    /* idle */
-    esp_printf(putc, "Type on the keyboard...\r\n");
-    while (1) asm("hlt");
+void main(uint32_t magic, uint32_t mbi_addr) {
+    /* Before any output, so that every step can be timed */
+    cpu_detect();
+    boot_tsc = rdtsc();
+    boot_magic = magic;
+    boot_mbi = mbi_addr;
+
+    initcall_run(boot_calls, NBOOT_CALLS, INIT_EARLY);
+    initcall_run(boot_calls, NBOOT_CALLS, INIT_CORE);
+
+#ifdef CONFIG_BENCH
+    initcall_run(boot_calls, NBOOT_CALLS, INIT_DEFERRED);
+    bench_run();   /* reports over COM1 and exits QEMU */
+#endif
+
+    /* Everything else runs on kernel threads; this one becomes idle */
+    thread_create("init", init_thread, init_progs);
+    thread_create("console", console_thread, 0);
+    thread_create("diag", diag_thread, 0);
+    esp_printf(putc, "Type on the keyboard... (F9: tracing on/off, F10: profile, F11: trace, F12: interrupt stats)\r\n");
+    initcall_ready();
+    sched_idle();
 }
@@ -3,6 +3,9 @@
 #include "interrupt.h"
 #include "terminal.h"
 #include "scancodes.h"
+#include "keyboard.h"
+#include "irqstat.h"
+#include "sched.h"
 
 extern uint8_t inb(uint16_t _port);
 extern void outb(uint16_t _port, uint8_t val);
@@ -16,20 +19,73 @@ char keyboard_map[128] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
+#define SC_F9  0x43
+#define SC_F10 0x44
+#define SC_F11 0x57
+#define SC_F12 0x58
+
+static volatile uint32_t hotkeys_pending;
+static struct wait_queue hotkey_wait;
+
+static char kbd_buf[KBD_BUF_SIZE];
+static volatile uint32_t kbd_head, kbd_tail;     // free-running
+static struct wait_queue kbd_wait;
+
+uint32_t kbd_take_hotkeys(void) {
+    uint32_t flags = irq_save();
+    uint32_t keys = hotkeys_pending;
+    hotkeys_pending = 0;
+    irq_restore(flags);
+    return keys;
+}
+
+uint32_t kbd_wait_hotkeys(void) {
+    uint32_t flags = irq_save();
+    while (!hotkeys_pending)
+        sleep_on(&hotkey_wait);
+    uint32_t keys = hotkeys_pending;
+    hotkeys_pending = 0;
+    irq_restore(flags);
+    return keys;
+}
+
+int kbd_getc(void) {
+    uint32_t flags = irq_save();
+    while (kbd_head == kbd_tail)
+        sleep_on(&kbd_wait);
+    int c = kbd_buf[kbd_tail++ & (KBD_BUF_SIZE - 1)];
+    irq_restore(flags);
+    return c;
+}
+
 __attribute__((interrupt))
 void keyboard_handler(struct interrupt_frame* frame)
 {
+    uint32_t t0 = irqstat_enter(0x21);
     uint8_t scancode = inb(0x60);
 
     // Ignore releases (bit 7 set)
     if (scancode & 0x80) {
         outb(0x20, 0x20);
+        irqstat_exit(0x21, t0);
         return;
     }
 
+    uint32_t keys = hotkeys_pending;
+    if (scancode == SC_F9)  hotkeys_pending |= HOTKEY_TRACE_ON;
+    if (scancode == SC_F10) hotkeys_pending |= HOTKEY_PROF;
+    if (scancode == SC_F11) hotkeys_pending |= HOTKEY_TRACE;
+    if (scancode == SC_F12) hotkeys_pending |= HOTKEY_IRQSTAT;
+    if (hotkeys_pending != keys) wake_up(&hotkey_wait);
+
+    /* Hand the character to whoever sleeps in kbd_getc() */
     char c = keyboard_map[scancode];
-    if (c) putc(c);
+    if (c && kbd_head - kbd_tail < KBD_BUF_SIZE) {
+        kbd_buf[kbd_head++ & (KBD_BUF_SIZE - 1)] = c;
+        wake_up(&kbd_wait);
+    }
 
     // Send EOI
     outb(0x20, 0x20);
+    irqstat_exit(0x21, t0);
 }
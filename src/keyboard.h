@@ -0,0 +1,26 @@
+// src/keyboard.h
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include <stdint.h>
+
+#define KBD_BUF_SIZE    64u          // pending characters, power of two
+
+/* Debug hotkeys: the IRQ handler only sets a bit and wakes the thread that
+   does the (slow) reporting outside interrupt context. */
+#define HOTKEY_IRQSTAT  (1u << 0)    // F12: dump per-vector interrupt stats
+#define HOTKEY_TRACE    (1u << 1)    // F11: dump trace rings to COM1
+#define HOTKEY_PROF     (1u << 2)    // F10: dump profiler samples to COM1
+#define HOTKEY_TRACE_ON (1u << 3)    // F9: switch tracing on or off
+
+/* Return and clear the pending hotkey bits */
+uint32_t kbd_take_hotkeys(void);
+
+/* Same, sleeping until at least one is pending */
+uint32_t kbd_wait_hotkeys(void);
+
+/* Next typed character, sleeping until there is one. Keys typed while
+   KBD_BUF_SIZE characters are pending are dropped. */
+int kbd_getc(void);
+
+#endif // KEYBOARD_H
@@ -0,0 +1,62 @@
+// src/kstring.c
+#include <stdint.h>
+#include "cpu.h"
+#include "kstring.h"
+
+// --- memcpy variants, picked by kstring_select_cpu() ---
+
+static void *memcpy_words(void *dst, const void *src, uint32_t n) {
+    uint8_t *d = (uint8_t*)dst;
+    const uint8_t *s = (const uint8_t*)src;
+
+    /* word copies when both sides are aligned (block and page buffers) */
+    if ((((uintptr_t)d | (uintptr_t)s) & 3) == 0) {
+        for (; n >= 4; n -= 4, d += 4, s += 4)
+            *(uint32_t*)d = *(const uint32_t*)s;
+    }
+    while (n--) *d++ = *s++;
+    return dst;
+}
+
+/* P6 and later have fast-string microcode: rep movsl beats any loop */
+static void *memcpy_rep(void *dst, const void *src, uint32_t n) {
+    void *d = dst;
+    uint32_t words = n >> 2, bytes = n & 3;
+    asm volatile("cld\n\trep movsl\n\tmov %3, %%ecx\n\trep movsb"
+                 : "+D"(d), "+S"(src), "+c"(words) : "r"(bytes) : "memory");
+    return dst;
+}
+
+#ifdef CONFIG_I686
+static void *(*memcpy_impl)(void *, const void *, uint32_t) = memcpy_rep;
+#else
+static void *(*memcpy_impl)(void *, const void *, uint32_t) = memcpy_words;
+#endif
+
+void kstring_select_cpu(void) {
+    memcpy_impl = cpu_info.family >= 6 ? memcpy_rep : memcpy_words;
+}
+
+void *memcpy(void *dst, const void *src, uint32_t n) {
+    return memcpy_impl(dst, src, n);
+}
+
+int memcmp(const void *a, const void *b, uint32_t n) {
+    const uint8_t *x = (const uint8_t*)a, *y = (const uint8_t*)b;
+    for (uint32_t i = 0; i < n; ++i)
+        if (x[i] != y[i]) return x[i] - y[i];
+    return 0;
+}
+
+int strcmp(const char *a, const char *b) {
+    while (*a && *a == *b) { a++; b++; }
+    return (uint8_t)*a - (uint8_t)*b;
+}
+
+int strncmp(const char *a, const char *b, uint32_t n) {
+    for (; n; --n, ++a, ++b) {
+        if (*a != *b) return (uint8_t)*a - (uint8_t)*b;
+        if (!*a) break;
+    }
+    return 0;
+}
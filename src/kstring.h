@@ -0,0 +1,21 @@
+// src/kstring.h
+#ifndef KSTRING_H
+#define KSTRING_H
+
+#include <stdint.h>
+
+/* Freestanding replacements for the few <string.h> routines we need.
+   (memset lives in interrupt.c with its historical signature.) */
+#ifdef HOST_TEST
+#include <string.h>                  // native test builds use the C library
+#else
+void *memcpy(void *dst, const void *src, uint32_t n);
+int   memcmp(const void *a, const void *b, uint32_t n);
+int   strcmp(const char *a, const char *b);
+int   strncmp(const char *a, const char *b, uint32_t n);
+
+/* Pick the memcpy variant for the CPU (after cpu_detect()) */
+void  kstring_select_cpu(void);
+#endif
+
+#endif // KSTRING_H
@@ -1,66 +1,100 @@
 // src/mmu.c
 #include <stdint.h>
 #include "page.h"
+#include "cpu.h"
+#include "panic.h"
+#include "swap.h"
 #include "rprintf.h"
 #include "terminal.h"
+#include "trace.h"
 
-/* These are the global paging structures (4KB aligned) */
+/* The kernel's pd and pt_low are prebuilt in boot_pt.S; the host tests
+   start from empty ones */
+#ifdef HOST_TEST
 struct page_directory_entry pd[1024] __attribute__((aligned(4096)));
 struct page                pt_low[1024] __attribute__((aligned(4096))); // for low 4MB
+#endif
 
-/* tiny memset to avoid dragging libc */
+/* tiny memset to avoid dragging libc; n is a multiple of 4 */
 static void memzero(void *p, uint32_t n) {
-    uint8_t *b = (uint8_t*)p;
-    for (uint32_t i = 0; i < n; ++i) b[i] = 0;
+    uint32_t *w = (uint32_t*)p;
+    for (uint32_t i = 0; i < n / 4; ++i) w[i] = 0;
 }
 
 void mmu_init(void) {
+#ifdef HOST_TEST
     memzero(pd,     sizeof(pd));
     memzero(pt_low, sizeof(pt_low));
+#else
+    if (pfa_base() + pfa_total_count() * 4096u > BOOT_MAP_END)
+        panic("frame pool ends past the prebuilt identity map (BOOT_MAP_PTS)");
+#endif
 }
 
-/* Ensure PD[dir] points to pt_low (we only need the first 4MB for this HW) */
-static inline void ensure_pt_low_present(uint32_t dir_index) {
-    (void)dir_index; // for this HW everything mapped is in the first 4MB (dir=0)
-
-    if (!pd[0].present) {
-        pd[0].present       = 1;
-        pd[0].rw            = 1;
-        pd[0].user          = 0;
-        pd[0].writethru     = 0;
-        pd[0].cachedisabled = 0;
-        pd[0].accessed      = 0;
-        pd[0].pagesize      = 0; // points to 4KB page table
-        pd[0].ignored       = 0;
-        pd[0].os_specific   = 0;
-        pd[0].frame         = ((uint32_t)pt_low) >> 12; // PT physical addr >> 12 (identity early)
+/* Point root_pd[dir] at a page table: pt_low for the kernel's first 4MB,
+   otherwise a fresh zeroed frame from the PFA (identity-mapped). */
+static int ensure_pt_present(struct page_directory_entry *root_pd, uint32_t dir) {
+    struct page_directory_entry *pde = &root_pd[dir];
+    uint32_t pt_phys;
+
+    if (pde->present) return 0;
+
+    if (root_pd == pd && dir == 0) {
+        pt_phys = (uint32_t)(uintptr_t)pt_low;   // PT physical addr (identity early)
+    } else {
+        pt_phys = pfa_alloc();
+        if (!pt_phys) return -1;
+        memzero((void*)(uintptr_t)pt_phys, 4096);
     }
+
+    pde->present       = 1;
+    pde->rw            = 1;
+    pde->user          = (dir >= (USER_BASE >> 22)); // PTEs still decide per page
+    pde->writethru     = 0;
+    pde->cachedisabled = 0;
+    pde->accessed      = 0;
+    pde->avail         = 0;
+    pde->pagesize      = 0; // points to 4KB page table
+    pde->ignored       = 0;
+    pde->os_specific   = 0;
+    pde->frame         = pt_phys >> 12;
+    return 0;
 }
 
-/* Map a list of physical 4KB pages starting at vaddr using the supplied PD */
-void *map_pages(void *vaddr, struct ppage *pglist, struct page_directory_entry *root_pd) {
-    (void)root_pd; // we use the global 'pd' but honor the prototype
+struct page *mmu_lookup_pte(struct page_directory_entry *root_pd, uint32_t va, int create) {
+    uint32_t dir = (va >> 22) & 0x3FF;  // bits 31..22
+    uint32_t tbl = (va >> 12) & 0x3FF;  // bits 21..12
+
+    if (!root_pd[dir].present) {
+        if (!create || ensure_pt_present(root_pd, dir)) return 0;
+    }
+    struct page *pt = (struct page*)(uintptr_t)(root_pd[dir].frame << 12);
+    return &pt[tbl];
+}
 
+/* Map a list of physical 4KB pages starting at vaddr with PTE_* flags */
+void *map_pages_flags(void *vaddr, struct ppage *pglist, struct page_directory_entry *root_pd,
+                      uint32_t flags) {
     uintptr_t va = (uintptr_t)vaddr;
     struct ppage *node = pglist;
 
     while (node) {
-        uint32_t dir = (va >> 22) & 0x3FF;  // bits 31..22
-        uint32_t tbl = (va >> 12) & 0x3FF;  // bits 21..12
-
-        // For this homework every target address (kernel @ 1MB, VGA @ 0xB8000, stack in .bss)
-        // is below 4MB, so dir == 0. We prepare pd[0] -> pt_low once.
-        ensure_pt_low_present(dir);
+        struct page *pte = mmu_lookup_pte(root_pd, va, 1);
+        if (!pte) return 0;
 
         // Fill the PTE for this page
-        struct page *pte = &pt_low[tbl];
-        pte->present  = 1;
-        pte->rw       = 1;
-        pte->user     = 0;
-        pte->accessed = 0;
-        pte->dirty    = 0;
-        pte->unused   = 0;
-        pte->frame    = (node->physical_addr >> 12); // store physical frame number
+        pte->present       = 1;
+        pte->rw            = (flags & PTE_W) ? 1 : 0;
+        pte->user          = (flags & PTE_U) ? 1 : 0;
+        pte->writethru     = 0;
+        pte->cachedisabled = 0;
+        pte->accessed      = 0;
+        pte->dirty         = 0;
+        pte->pat           = 0;
+        pte->global        = (flags & PTE_G) ? 1 : 0;
+        pte->os_specific   = (flags >> 9) & 7;
+        pte->frame         = (node->physical_addr >> 12); // store physical frame number
+        TRACE(TR_MAP_PAGE, va, node->physical_addr, root_pd);
 
         va   += 4096;
         node  = node->next;
@@ -69,19 +103,140 @@ void *map_pages(void *vaddr, struct ppage *pglist, struct page_directory_entry *
     return vaddr;
 }
 
+/* Kernel mapping: present, writable, supervisor-only */
+void *map_pages(void *vaddr, struct ppage *pglist, struct page_directory_entry *root_pd) {
+    return map_pages_flags(vaddr, pglist, root_pd, PTE_W);
+}
+
+/* Clear 'npages' PTEs starting at vaddr. Frames are not freed; the caller
+   owns them (it got them from pfa_alloc and handed them to map_pages). */
+void unmap_pages(void *vaddr, uint32_t npages, struct page_directory_entry *root_pd) {
+    uintptr_t va = (uintptr_t)vaddr;
+    for (uint32_t i = 0; i < npages; ++i, va += 4096) {
+        struct page *pte = mmu_lookup_pte(root_pd, va, 0);
+        if (pte) *(uint32_t*)pte = 0;
+    }
+    mmu_flush_range((uint32_t)(uintptr_t)vaddr, npages);
+}
+
+void mmu_release(struct page_directory_entry *root_pd, uint32_t va, uint32_t npages) {
+    const uint32_t va0 = va, n0 = npages;
+    int dirty = 0;
+    while (npages) {
+        if (!root_pd[va >> 22].present) {
+            uint32_t skip = 1024 - ((va >> 12) & 0x3FF);   // rest of this 4MB
+            if (skip >= npages) break;
+            npages -= skip;
+            va += skip << 12;
+            continue;
+        }
+        struct page *pte = mmu_lookup_pte(root_pd, va, 0);
+        if (pte->present) {
+            if (pte->os_specific & (PTE_OWNED >> 9)) pfa_free(pte->frame << 12);
+            *(uint32_t*)pte = 0;
+            dirty = 1;
+        } else if (pte->os_specific & (PTE_SWAP >> 9)) {
+            swap_free(pte->frame);
+            *(uint32_t*)pte = 0;
+        }
+        va += 4096;
+        npages--;
+    }
+    if (dirty) mmu_flush_range(va0, n0);
+}
+
+/* New address space: user half empty, kernel half shared with 'pd' */
+struct page_directory_entry *mmu_create_pd(void) {
+    uint32_t frame = pfa_alloc();
+    if (!frame) return 0;
+
+    struct page_directory_entry *npd = (struct page_directory_entry*)(uintptr_t)frame;
+    memzero(npd, 4096);
+    for (uint32_t dir = 0; dir < (USER_BASE >> 22); ++dir)
+        npd[dir] = pd[dir];
+    return npd;
+}
+
+/* Free the user half of an address space: frames marked PTE_OWNED, swap
+   slots, the page tables, then the directory itself. */
+void mmu_destroy_pd(struct page_directory_entry *root_pd) {
+    for (uint32_t dir = (USER_BASE >> 22); dir < 1024; ++dir) {
+        if (!root_pd[dir].present) continue;
+        struct page *pt = (struct page*)(uintptr_t)(root_pd[dir].frame << 12);
+        for (uint32_t i = 0; i < 1024; ++i) {
+            if (pt[i].present && (pt[i].os_specific & (PTE_OWNED >> 9)))
+                pfa_free(pt[i].frame << 12);
+            else if (!pt[i].present && (pt[i].os_specific & (PTE_SWAP >> 9)))
+                swap_free(pt[i].frame);
+        }
+        pfa_free(root_pd[dir].frame << 12);
+    }
+    pfa_free((uint32_t)(uintptr_t)root_pd);
+}
+
+/* i386 has no invlpg, so drop the whole TLB by reloading CR3 */
+void flush_tlb(void) {
+#ifndef HOST_TEST
+    asm volatile("mov %%cr3, %%eax\n\tmov %%eax, %%cr3" : : : "eax", "memory");
+#endif
+}
+
+/* Per-page flushes, chosen once by mmu_select_cpu(). A 386 has no invlpg:
+   there a single page costs a full flush, so ranges go straight to one. */
+static void flush_page_cr3(uint32_t va) { (void)va; flush_tlb(); }
+
+static void flush_page_invlpg(uint32_t va) {
+#ifndef HOST_TEST
+    asm volatile("invlpg (%0)" : : "r"(va) : "memory");
+#endif
+}
+
+#ifdef CONFIG_I686
+static void (*flush_page)(uint32_t va) = flush_page_invlpg;
+#else
+static void (*flush_page)(uint32_t va) = flush_page_cr3;
+#endif
+
+void mmu_select_cpu(void) {
+    flush_page = cpu_info.invlpg ? flush_page_invlpg : flush_page_cr3;
+}
+
+void mmu_flush_range(uint32_t va, uint32_t npages) {
+    if (flush_page == flush_page_cr3 || npages > MMU_INVLPG_MAX) {
+        flush_tlb();
+        return;
+    }
+    for (uint32_t i = 0; i < npages; ++i)
+        flush_page(va + i * 4096u);
+}
+
+void mmu_enable_global(void) {
+#ifndef HOST_TEST
+    if (!cpu_has(CPUID_PGE)) return;
+    uint32_t cr4;
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+    asm volatile("mov %0, %%cr4" : : "r"(cr4 | 0x80) : "memory");
+#endif
+}
+
 /* Load CR3 with the physical address of the page directory */
 void loadPageDirectory(struct page_directory_entry *dir) {
+#ifndef HOST_TEST
     asm volatile("mov %0, %%cr3" : : "r"(dir) : "memory");
+#endif
 }
 
-/* Enable paging by setting CR0.PG and CR0.PE (bit 31 and bit 0) */
+/* Enable paging by setting CR0.PG and CR0.PE (bit 31 and bit 0), and
+   CR0.WP (bit 16) so ring 0 honours read-only PTEs too */
 void enable_paging(void) {
+#ifndef HOST_TEST
     asm volatile(
         "mov %%cr0, %%eax\n\t"
-        "or  $0x80000001, %%eax\n\t"  /* PG|PE */
+        "or  $0x80010001, %%eax\n\t"  /* PG|WP|PE */
         "mov %%eax, %%cr0\n\t"
         :
         :
         : "eax", "memory"
     );
+#endif
 }
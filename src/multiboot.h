@@ -0,0 +1,32 @@
+// src/multiboot.h
+#ifndef MULTIBOOT_H
+#define MULTIBOOT_H
+
+#include <stdint.h>
+
+/* Multiboot (v1) boot information, as handed over in EBX by GRUB's
+   "multiboot" command. Only the fields the kernel reads are named. */
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002
+
+#define MULTIBOOT_INFO_MEMORY  (1u << 0)
+#define MULTIBOOT_INFO_CMDLINE (1u << 2)
+#define MULTIBOOT_INFO_MODS    (1u << 3)
+
+struct multiboot_info {
+    uint32_t flags;
+    uint32_t mem_lower;              // KB below 1MB
+    uint32_t mem_upper;              // KB above 1MB
+    uint32_t boot_device;
+    uint32_t cmdline;
+    uint32_t mods_count;
+    uint32_t mods_addr;              // physical address of multiboot_module[]
+} __attribute__((packed));
+
+struct multiboot_module {
+    uint32_t mod_start;              // physical, page-aligned (ALIGN flag in start.s)
+    uint32_t mod_end;                // one past the last byte
+    uint32_t string;                 // the rest of the "module" line
+    uint32_t reserved;
+} __attribute__((packed));
+
+#endif // MULTIBOOT_H
@@ -2,18 +2,22 @@
 #include "page.h"
 #include "rprintf.h"
 #include "terminal.h"
+#include "trace.h"
 
 // Linker symbol from kernel.ld
 extern uint8_t _end_kernel;
 
 // --- Tunables --------------------------------------------------------------
-#define PFA_MAX_FRAMES 8192u
 #define FRAME_SIZE     4096u
 
 static uint32_t bitmap[(PFA_MAX_FRAMES + 31u) / 32u];
 static uint32_t total_frames = 0;
 static uintptr_t base_addr   = 0;
 
+/* Reverse map: the user mapping of each reclaimable frame, 0 for the rest */
+static struct pfa_owner owners[PFA_MAX_FRAMES];
+static uint32_t (*reclaimer)(void);
+
 // --- Helpers ---------------------------------------------------------------
 static inline void bzero32(uint32_t *p, uint32_t n_words) {
     for (uint32_t i = 0; i < n_words; ++i) p[i] = 0;
@@ -21,7 +25,6 @@ static inline void bzero32(uint32_t *p, uint32_t n_words) {
 
 static inline void set_bit(uint32_t idx)   { bitmap[idx >> 5] |=  (1u << (idx & 31)); }
 static inline void clear_bit(uint32_t idx) { bitmap[idx >> 5] &= ~(1u << (idx & 31)); }
-static inline uint32_t test_bit(uint32_t idx) { return (bitmap[idx >> 5] >> (idx & 31)) & 1u; }
 
 // --- API -------------------------------------------------------------------
 void pfa_init(void) {
@@ -31,33 +34,97 @@ void pfa_init(void) {
     base_addr    = aligned;
     total_frames = PFA_MAX_FRAMES;
     bzero32(bitmap, (PFA_MAX_FRAMES + 31u) / 32u);
+    bzero32((uint32_t*)owners, sizeof(owners) / 4u);
+    reclaimer = 0;
 
     esp_printf(putc, "PFA: base=%p, frames=%u (%u KB)\r\n",
                (void*)base_addr, total_frames, (total_frames * FRAME_SIZE) / 1024u);
 }
 
-uint32_t pfa_alloc(void) {
-    for (uint32_t i = 0; i < total_frames; ++i) {
-        if (!test_bit(i)) {
-            set_bit(i);
-            return (uint32_t)(base_addr + (uintptr_t)i * FRAME_SIZE);
-        }
+static inline uint32_t popcount32(uint32_t x) {
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+    return (x * 0x01010101u) >> 24;
+}
+
+/* First fit, a word at a time: full words are skipped whole and bsf
+   (__builtin_ctz, on every x86 since the 386) finds the free bit */
+static uint32_t alloc_scan(void) {
+    for (uint32_t w = 0; w < (total_frames + 31u) / 32u; ++w) {
+        if (bitmap[w] == 0xFFFFFFFFu) continue;
+        uint32_t i = w * 32u + (uint32_t)__builtin_ctz(~bitmap[w]);
+        if (i >= total_frames) break;
+        set_bit(i);
+        uint32_t addr = (uint32_t)(base_addr + (uintptr_t)i * FRAME_SIZE);
+        TRACE(TR_PFA_ALLOC, addr, i, 0);
+        return addr;
     }
     return 0;
 }
 
+/* When the pool is empty the reclaimer gets a chance to evict user pages
+   before the allocation fails. It may not allocate frames itself. */
+uint32_t pfa_alloc(void) {
+    static int reclaiming;
+    uint32_t addr = alloc_scan();
+
+    if (!addr && reclaimer && !reclaiming) {
+        reclaiming = 1;
+        if (reclaimer()) addr = alloc_scan();
+        reclaiming = 0;
+    }
+    if (!addr) TRACE(TR_PFA_ALLOC, 0, 0, 0);
+    return addr;
+}
+
+void pfa_set_reclaimer(uint32_t (*fn)(void)) { reclaimer = fn; }
+
 void pfa_free(uint32_t frame_addr) {
     if (frame_addr < base_addr) return;
     uint32_t idx = (uint32_t)((frame_addr - base_addr) / FRAME_SIZE);
     if (idx >= total_frames) return;
+    TRACE(TR_PFA_FREE, frame_addr, 0, 0);
+    owners[idx].pd = 0;
     clear_bit(idx);
 }
 
+static struct pfa_owner *owner_slot(uint32_t frame_addr) {
+    if (frame_addr < base_addr) return 0;
+    uint32_t idx = (uint32_t)((frame_addr - base_addr) / FRAME_SIZE);
+    return idx < total_frames ? &owners[idx] : 0;
+}
+
+void pfa_set_owner(uint32_t frame_addr, struct page_directory_entry *dir, uint32_t va) {
+    struct pfa_owner *o = owner_slot(frame_addr);
+    if (!o) return;
+    o->pd = dir;
+    o->va = va;
+}
+
+const struct pfa_owner *pfa_owner(uint32_t idx) {
+    return (idx < total_frames && owners[idx].pd) ? &owners[idx] : 0;
+}
+
+/* Take frames that something else already occupies (boot modules) out of
+   the pool. Addresses outside the pool are ignored. */
+void pfa_reserve(uint32_t start, uint32_t end) {
+    uintptr_t lo = start & ~(uintptr_t)(FRAME_SIZE - 1u);
+    for (uintptr_t a = lo; a < end; a += FRAME_SIZE) {
+        if (a < base_addr) continue;
+        uint32_t idx = (uint32_t)((a - base_addr) / FRAME_SIZE);
+        if (idx >= total_frames) break;
+        set_bit(idx);
+    }
+}
+
 uint32_t pfa_total_count(void) { return total_frames; }
 
+uint32_t pfa_base(void) { return (uint32_t)base_addr; }
+
 uint32_t pfa_free_count(void) {
     uint32_t used = 0;
-    for (uint32_t i = 0; i < total_frames; ++i)
-        used += test_bit(i);
+    for (uint32_t w = 0; w < (total_frames + 31u) / 32u; ++w)
+        used += popcount32(bitmap[w]);
     return total_frames - used;
 }
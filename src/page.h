@@ -2,6 +2,24 @@
 #ifndef PAGE_H
 #define PAGE_H
 
+/* Also read by the assembler (src/boot_pt.S): constants only up to the
+   __ASSEMBLER__ guard */
+
+#define PFA_MAX_FRAMES 8192          // frames in the pool after the kernel image
+
+/* Flags for map_pages_flags(); bits 9..11 land in os_specific */
+#define PTE_W      0x002         // writable
+#define PTE_U      0x004         // user accessible
+#define PTE_G      0x100         // global: survives CR3 reloads once CR4.PGE is on
+#define PTE_OWNED  0x200         // frame is freed with the address space
+#define PTE_SWAP   0x400         // not present: 'frame' holds a swap slot
+
+/* Page tables of the boot identity map; the whole pool must fit below
+   BOOT_MAP_END, which kernel.ld checks */
+#define BOOT_MAP_PTS   12
+#define BOOT_MAP_END   (BOOT_MAP_PTS << 22)
+
+#ifndef __ASSEMBLER__
 #include <stdint.h>
 
 /* -------------------- HW3: Page Frame Allocator API -------------------- */
@@ -10,6 +28,22 @@ uint32_t pfa_alloc(void);
 void     pfa_free(uint32_t frame_addr);
 uint32_t pfa_total_count(void);
 uint32_t pfa_free_count(void);
+uint32_t pfa_base(void);         // first frame address (pool is identity-mapped)
+void     pfa_reserve(uint32_t start, uint32_t end);  // mark [start, end) in use
+
+/* Reverse map for page reclaim: which user mapping a frame backs. Set by the
+   page-fault handler, cleared by pfa_free(); pfa_owner() takes a frame
+   index (0 .. pfa_total_count()-1) and returns 0 for unowned frames. */
+struct page_directory_entry;
+struct pfa_owner {
+    struct page_directory_entry *pd;
+    uint32_t va;
+};
+void pfa_set_owner(uint32_t frame_addr, struct page_directory_entry *pd, uint32_t va);
+const struct pfa_owner *pfa_owner(uint32_t idx);
+
+/* Called by pfa_alloc() when the pool is empty; returns frames freed */
+void pfa_set_reclaimer(uint32_t (*fn)(void));
 
 /* -------------------- HW4: Paging data structures & API -------------------- */
 
@@ -27,24 +61,37 @@ struct page_directory_entry {
     uint32_t writethru     : 1;  // write-through (usually 0)
     uint32_t cachedisabled : 1;  // disable cache (usually 0)
     uint32_t accessed      : 1;  // accessed (CPU sets)
-    uint32_t pagesize      : 1;  // 0 = points to page table (4KB pages)
-    uint32_t ignored       : 2;  // ignored/reserved
+    uint32_t avail         : 1;  // bit 6, ignored for 4KB tables
+    uint32_t pagesize      : 1;  // bit 7, 0 = points to page table (4KB pages)
+    uint32_t ignored       : 1;  // global, ignored for 4KB tables
     uint32_t os_specific   : 3;  // available to OS
     uint32_t frame         : 20; // page table phys addr >> 12
 };
 
 /* i386 Page Table Entry (PTE), 4KB page */
 struct page {
-    uint32_t present    : 1;
-    uint32_t rw         : 1;
-    uint32_t user       : 1;
-    uint32_t accessed   : 1;
-    uint32_t dirty      : 1;
-    uint32_t unused     : 7;
-    uint32_t frame      : 20;  // physical frame >> 12
+    uint32_t present       : 1;
+    uint32_t rw            : 1;
+    uint32_t user          : 1;
+    uint32_t writethru     : 1;
+    uint32_t cachedisabled : 1;
+    uint32_t accessed      : 1;  // bit 5, set by the CPU on any access
+    uint32_t dirty         : 1;  // bit 6, set by the CPU on write
+    uint32_t pat           : 1;
+    uint32_t global        : 1;
+    uint32_t os_specific   : 3;  // available to OS (see PTE_OWNED)
+    uint32_t frame         : 20; // physical frame >> 12
 };
 
-/* Global, 4KB-aligned paging structures (defined in mmu.c) */
+/* Virtual addresses below USER_BASE are the kernel's (identity-mapped and
+   shared by every page directory); user mappings live above it. */
+#define USER_BASE  0x08000000u
+#define USER_TOP   0xC0000000u
+
+/* Global, 4KB-aligned paging structures. In the kernel they are
+   prebuilt by src/boot_pt.S: pd[0..BOOT_MAP_PTS) already identity-map
+   the VGA page and [1MB, BOOT_MAP_END), and pt_low is the first of those
+   page tables. Host tests get empty ones from mmu.c. */
 extern struct page_directory_entry pd[1024];
 extern struct page                pt_low[1024];
 
@@ -52,13 +99,51 @@ extern struct page                pt_low[1024];
    Returns the starting virtual address on success. */
 void *map_pages(void *vaddr, struct ppage *pglist, struct page_directory_entry *pd);
 
-/* Initialize PD/PT (zero them) — simple helper */
+/* Same, with explicit PTE_* flags. Page tables are allocated on demand. */
+void *map_pages_flags(void *vaddr, struct ppage *pglist, struct page_directory_entry *pd,
+                      uint32_t flags);
+
+/* PTE for 'va', or 0 if its page table is missing and create == 0 */
+struct page *mmu_lookup_pte(struct page_directory_entry *pd, uint32_t va, int create);
+
+/* Clear npages PTEs from va, freeing the PTE_OWNED frames and swap slots
+   among them. Missing page tables are skipped 4MB at a time, so sparse ranges are cheap. */
+void mmu_release(struct page_directory_entry *pd, uint32_t va, uint32_t npages);
+
+/* Per-process page directories sharing the kernel mappings below USER_BASE */
+struct page_directory_entry *mmu_create_pd(void);
+void mmu_destroy_pd(struct page_directory_entry *pd);
+
+/* Clears 'npages' consecutive mappings starting at 'vaddr' and flushes the TLB.
+   The physical frames are left to the caller. */
+void unmap_pages(void *vaddr, uint32_t npages, struct page_directory_entry *pd);
+
+/* Flush all non-global TLB entries */
+void flush_tlb(void);
+
+/* Flush the translations of npages pages from va in the loaded address
+   space: invlpg per page on a 486 or later, a full flush_tlb() on a 386
+   or for long ranges */
+#define MMU_INVLPG_MAX 32u
+void mmu_flush_range(uint32_t va, uint32_t npages);
+
+/* Pick the TLB routines for the CPU (after cpu_detect()) */
+void mmu_select_cpu(void);
+
+/* Turn on CR4.PGE when the CPU has it, so the PTE_G kernel mappings stay
+   in the TLB across address-space switches. Call after enable_paging(). */
+void mmu_enable_global(void);
+
+/* Kernel: check that the frame pool lies inside the prebuilt identity
+   map (after pfa_init()). Host tests: zero pd and pt_low. */
 void mmu_init(void);
 
 /* Load CR3 with PD physical address */
 void loadPageDirectory(struct page_directory_entry *pd);
 
-/* Enable paging: set CR0.PG | CR0.PE (bit 31 and bit 0) */
+/* Enable paging: set CR0.PG | CR0.WP | CR0.PE (bits 31, 16 and 0) */
 void enable_paging(void);
 
+#endif // __ASSEMBLER__
+
 #endif // PAGE_H
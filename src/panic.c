@@ -0,0 +1,44 @@
+// src/panic.c
+#include <stdarg.h>
+#include <stdint.h>
+#include "page.h"
+#include "panic.h"
+#include "rprintf.h"
+#include "serial.h"
+#include "terminal.h"
+
+#define PANIC_FRAMES 8
+#define KERNEL_BASE  0x00100000u
+#define MAX_FRAME    0x4000u
+
+static void report(func_ptr out, char *fmt, va_list ap) {
+    esp_printf(out, "\r\nPANIC: ");
+    esp_vprintf(out, fmt, ap);
+    esp_printf(out, "\r\n");
+
+    /* Same bounded EBP walk as the profiler */
+    uint32_t fp = (uint32_t)(uintptr_t)__builtin_frame_address(0);
+    for (int i = 0; i < PANIC_FRAMES; ++i) {
+        if (fp < KERNEL_BASE || fp > BOOT_MAP_END - 8 || (fp & 3)) break;
+        uint32_t next = ((uint32_t*)fp)[0];
+        uint32_t ret  = ((uint32_t*)fp)[1];
+        if (ret < KERNEL_BASE) break;
+        esp_printf(out, "  [<%08x>]\r\n", ret);
+        if (next <= fp || next - fp > MAX_FRAME) break;
+        fp = next;
+    }
+}
+
+void panic(char *fmt, ...) {
+    va_list ap;
+
+    asm volatile("cli");
+    va_start(ap, fmt);
+    report(putc, fmt, ap);
+    va_end(ap);
+    va_start(ap, fmt);
+    report(serial_putc, fmt, ap);
+    va_end(ap);
+
+    while (1) asm volatile("hlt");
+}
@@ -0,0 +1,9 @@
+// src/panic.h
+#ifndef PANIC_H
+#define PANIC_H
+
+/* Report on the screen and COM1 with a short backtrace, then stop the
+   machine. For kernel bugs only; faults in ring 3 kill the process. */
+void panic(char *fmt, ...) __attribute__((noreturn));
+
+#endif // PANIC_H
@@ -0,0 +1,35 @@
+// src/pci.c
+#include <stdint.h>
+#include "interrupt.h"
+#include "pci.h"
+
+/* Configuration mechanism #1 */
+uint32_t pci_read32(pci_bdf bdf, uint8_t off) {
+    outl(PCI_CONFIG_ADDR, 0x80000000u | bdf | (off & 0xFC));
+    return inl(PCI_CONFIG_DATA);
+}
+
+void pci_write32(pci_bdf bdf, uint8_t off, uint32_t val) {
+    outl(PCI_CONFIG_ADDR, 0x80000000u | bdf | (off & 0xFC));
+    outl(PCI_CONFIG_DATA, val);
+}
+
+int pci_find_class(uint8_t cls, uint8_t subcls, pci_bdf *out) {
+    for (uint32_t bus = 0; bus < 256; ++bus) {
+        for (uint32_t dev = 0; dev < 32; ++dev) {
+            for (uint32_t fn = 0; fn < 8; ++fn) {
+                pci_bdf bdf = PCI_BDF(bus, dev, fn);
+                if ((pci_read32(bdf, 0) & 0xFFFF) == 0xFFFF) {
+                    if (fn == 0) break;          // no device here at all
+                    continue;
+                }
+                uint32_t cr = pci_read32(bdf, PCI_CLASS_REVISION);
+                if ((cr >> 24) == cls && ((cr >> 16) & 0xFF) == subcls) {
+                    *out = bdf;
+                    return 0;
+                }
+            }
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,26 @@
+// src/pci.h
+#ifndef PCI_H
+#define PCI_H
+
+#include <stdint.h>
+
+#define PCI_CONFIG_ADDR 0xCF8
+#define PCI_CONFIG_DATA 0xCFC
+
+#define PCI_COMMAND         0x04
+#define PCI_CLASS_REVISION  0x08
+#define PCI_BAR4            0x20
+#define PCI_CMD_IO          0x0001
+#define PCI_CMD_BUSMASTER   0x0004
+
+/* bus/device/function packed as in the config address register */
+typedef uint32_t pci_bdf;
+#define PCI_BDF(bus, dev, fn) (((uint32_t)(bus) << 16) | ((uint32_t)(dev) << 11) | ((uint32_t)(fn) << 8))
+
+uint32_t pci_read32(pci_bdf bdf, uint8_t off);
+void     pci_write32(pci_bdf bdf, uint8_t off, uint32_t val);
+
+/* Find the first function with this class/subclass; returns 0 if found */
+int pci_find_class(uint8_t cls, uint8_t subcls, pci_bdf *out);
+
+#endif // PCI_H
@@ -0,0 +1,280 @@
+// src/proc.c
+#include <stdint.h>
+#include "proc.h"
+#include "chan.h"
+#include "elf.h"
+#include "fat.h"
+#include "initrd.h"
+#include "kstring.h"
+#include "page.h"
+#include "cpu.h"
+#include "fpu.h"
+#include "rprintf.h"
+#include "trace.h"
+#include "sched.h"
+#include "swap.h"
+#include "panic.h"
+
+#undef putc
+extern int putc(int);
+
+/* isr.s */
+extern int  user_enter(uint32_t eip, uint32_t esp, uint32_t *kesp);
+extern void user_return(uint32_t kesp, int code) __attribute__((noreturn));
+
+extern void memset(char *s, char c, unsigned int n);
+
+static struct proc procs[PROC_MAX];
+struct proc *current;
+static int next_pid = 1;
+
+int user_range_ok(uint32_t addr, uint32_t len) {
+    return addr >= USER_BASE && addr <= USER_TOP && len <= USER_TOP - addr;
+}
+
+int user_access_ok(uint32_t addr, uint32_t len, uint32_t flags) {
+    return current && user_range_ok(addr, len) && vma_covers(&current->vmas, addr, addr + len, flags);
+}
+
+// --- Loading ---
+
+/* pread() on whichever file backs the process */
+static int image_read(struct proc *p, void *buf, uint32_t n, uint32_t off) {
+    if (p->fd >= 0)
+        return fat_pread(p->fd, buf, n, off);
+
+    const void *src;
+    uint32_t got = initrd_read(&p->image, off, n, &src);
+    if (got == 4096 && !(((uintptr_t)buf | (uintptr_t)src) & 15))
+        copy_page(buf, src);                 // a whole page of text or data
+    else
+        memcpy(buf, src, got);
+    return (int)got;
+}
+
+static void image_close(struct proc *p) {
+    if (p->fd >= 0) fat_close(p->fd);
+}
+
+static inline uint32_t page_up(uint32_t x) { return (x + 4095u) & ~4095u; }
+
+/* Segments whose page ranges touch one page (text ending where data
+   starts) share a VMA with the union of their permissions. */
+static int add_segment_vma(struct proc *p, uint32_t lo, uint32_t hi, uint32_t flags) {
+    struct vma *v;
+    while ((v = vma_next(&p->vmas, lo)) && v->start < hi) {
+        if (v->start < lo) lo = v->start;
+        if (v->end > hi) hi = v->end;
+        flags |= v->flags;
+        vma_remove(&p->vmas, v);
+    }
+    return vma_insert(&p->vmas, lo, hi, flags) ? 0 : -1;
+}
+
+static int load_segments(struct proc *p, struct elf32_ehdr *eh) {
+    struct elf32_phdr ph;
+
+    for (uint32_t i = 0; i < eh->phnum; ++i) {
+        if (image_read(p, &ph, sizeof(ph), eh->phoff + i * eh->phentsize) != sizeof(ph))
+            return -1;
+        if (ph.type != PT_LOAD || ph.memsz == 0)
+            continue;
+        if (p->nseg == PROC_MAX_SEGS || ph.filesz > ph.memsz ||
+            !user_range_ok(ph.vaddr, ph.memsz) ||
+            ph.vaddr + ph.memsz > USER_STACK_TOP - USER_STACK_SIZE)
+            return -1;
+
+        struct proc_seg *s = &p->seg[p->nseg++];
+        s->vaddr    = ph.vaddr;
+        s->memsz    = ph.memsz;
+        s->filesz   = ph.filesz;
+        s->offset   = ph.offset;
+
+        uint32_t end = page_up(ph.vaddr + ph.memsz);
+        uint32_t flags = VMA_READ | VMA_FILE | ((ph.flags & PF_W) ? VMA_WRITE : 0);
+        if (add_segment_vma(p, ph.vaddr & ~0xFFFu, end, flags) != 0)
+            return -1;
+        if (end > p->brk_start)
+            p->brk_start = p->brk = end;
+    }
+    if (!p->nseg) return -1;
+
+    return vma_insert(&p->vmas, USER_STACK_TOP - USER_STACK_SIZE, USER_STACK_TOP,
+                      VMA_READ | VMA_WRITE | VMA_ANON | VMA_STACK) ? 0 : -1;
+}
+
+/* Only the headers are read here; every page of the image is brought in by
+   proc_page_fault() when the program first touches it. */
+int proc_exec(const char *path) {
+    struct proc *p = 0;
+    struct elf32_ehdr eh;
+    int code;
+
+    for (int i = 0; i < PROC_MAX; ++i)
+        if (procs[i].state == PROC_FREE) { p = &procs[i]; break; }
+    if (!p) return -1;
+
+    memset((char*)p, 0, sizeof(*p));
+    vma_init(&p->vmas);
+    p->fd = -1;
+    if (initrd_lookup(path, &p->image) != 0) {
+        p->fd = fat_open(path);
+        if (p->fd < 0) return -1;
+    }
+
+    if (image_read(p, &eh, sizeof(eh), 0) != sizeof(eh) ||
+        eh.magic != ELF_MAGIC || eh.class != ELFCLASS32 || eh.data != ELFDATA2LSB ||
+        eh.type != ET_EXEC || eh.machine != EM_386 ||
+        eh.phentsize < sizeof(struct elf32_phdr) ||
+        load_segments(p, &eh) != 0 ||
+        !user_range_ok(eh.entry, 1)) {
+        esp_printf(putc, "exec %s: not a loadable ELF32 i386 executable\r\n", path);
+        vma_clear(&p->vmas);
+        image_close(p);
+        return -1;
+    }
+
+    p->pd = mmu_create_pd();
+    if (!p->pd) {
+        vma_clear(&p->vmas);
+        image_close(p);
+        return -1;
+    }
+    p->pid   = next_pid++;
+    p->state = PROC_RUNNING;
+
+    sched_attach(p);
+    fpu_release(current_thread);         // the program starts with a clean FPU
+    code = user_enter(eh.entry, USER_STACK_TOP, &p->kesp);
+    sched_attach(0);
+
+    esp_printf(putc, "pid %d (%s) exited with %d: %u pages faulted in (%u mapped from the initrd), %u cycles/fault\r\n",
+               p->pid, path, code, p->faults, p->shared, p->faults ? p->fault_cycles / p->faults : 0);
+
+    chan_release(p->pid);
+    vma_clear(&p->vmas);
+    mmu_destroy_pd(p->pd);
+    image_close(p);
+    p->state = PROC_FREE;
+    return code;
+}
+
+void proc_exit(int code) {
+    user_return(current->kesp, code);
+}
+
+void proc_kill_current(uint32_t vector) {
+    esp_printf(putc, "pid %d killed by exception %u\r\n", current->pid, vector);
+    user_return(current->kesp, -(int)vector);
+}
+
+// --- Demand paging ---
+
+/* Fill a fresh frame for user page 'va' of a file-backed VMA: bytes from
+   every segment overlapping the page, zeros elsewhere. */
+static int fill_page(struct proc *p, uint32_t va, uint8_t *frame) {
+    for (uint32_t i = 0; i < p->nseg; ++i) {
+        struct proc_seg *s = &p->seg[i];
+        if (va + 4096 <= s->vaddr || va >= s->vaddr + s->memsz)
+            continue;
+
+        uint32_t lo = va > s->vaddr ? va : s->vaddr;
+        uint32_t hi = va + 4096;
+        if (hi > s->vaddr + s->filesz) hi = s->vaddr + s->filesz;
+        if (lo < hi &&
+            image_read(p, frame + (lo - va), hi - lo, s->offset + (lo - s->vaddr)) != (int)(hi - lo))
+            return -1;
+    }
+    return 0;
+}
+
+/* The initrd page that user page 'va' can map as it is, or 0. That takes
+   a read-only page of exactly one segment with no bss, whose file page
+   is whole and page-aligned in the module (tools/mkinitrd.py aligns the
+   members); like a file mapping, bytes around the segment in that file
+   page show through. Everything else is built in a fresh frame. */
+static uint32_t image_page(struct proc *p, uint32_t va) {
+    const struct proc_seg *hit = 0;
+    const void *src;
+
+    if (p->fd >= 0) return 0;
+    for (uint32_t i = 0; i < p->nseg; ++i) {
+        const struct proc_seg *s = &p->seg[i];
+        if (va + 4096 <= s->vaddr || va >= s->vaddr + s->memsz)
+            continue;
+        if (hit || s->filesz != s->memsz || ((s->vaddr ^ s->offset) & 0xFFF))
+            return 0;
+        hit = s;
+    }
+    if (!hit || initrd_read(&p->image, hit->offset + va - hit->vaddr, 4096, &src) != 4096 ||
+        ((uintptr_t)src & 0xFFF))
+        return 0;
+    return (uint32_t)(uintptr_t)src;
+}
+
+void proc_page_fault(struct trapframe *tf) {
+    uint32_t cr2, t0 = (uint32_t)rdtsc();
+    asm volatile("mov %%cr2, %0" : "=r"(cr2));
+    TRACE(TR_PAGE_FAULT, cr2, tf->err, tf->eip);
+
+    int from_user = (tf->cs & 3) != 0;
+    int user_va = cr2 >= USER_BASE && cr2 < USER_TOP;
+    uint32_t va = cr2 & ~0xFFFu;
+    struct vma *v = current ? vma_find(&current->vmas, cr2) : 0;
+
+    /* err bit 0: the page was present, so this is a protection violation;
+       bit 1: a write. CR0.WP is set, so a kernel write faults like a user
+       one; syscalls check user_access_ok(..., VMA_WRITE) first. */
+    if (v && !(tf->err & 1) && (!(tf->err & 2) || (v->flags & VMA_WRITE))) {
+        /* Read-only text and rodata from the initrd: map the module's own
+           frame, not owned, so it is neither copied nor freed nor reclaimed */
+        uint32_t shared = ((v->flags & (VMA_FILE | VMA_WRITE)) == VMA_FILE && !(tf->err & 2))
+                          ? image_page(current, va) : 0;
+        if (shared) {
+            struct ppage pg = { .physical_addr = shared, .next = 0 };
+            if (map_pages_flags((void*)va, &pg, current->pd, PTE_U)) {
+                current->faults++;
+                current->shared++;
+                current->fault_cycles += (uint32_t)rdtsc() - t0;
+                return;
+            }
+        }
+
+        uint32_t frame = pfa_alloc();     // may evict pages, but never this one
+        if (frame) {
+            struct page *pte = mmu_lookup_pte(current->pd, va, 0);
+            int swapped = pte && (pte->os_specific & (PTE_SWAP >> 9));
+            int ok;
+
+            if (swapped) {
+                ok = swap_in(pte, frame) == 0;
+            } else {
+                zero_page((void*)(uintptr_t)frame);
+                ok = !(v->flags & VMA_FILE) || fill_page(current, va, (uint8_t*)(uintptr_t)frame) == 0;
+            }
+            if (ok) {
+                struct ppage pg = { .physical_addr = frame, .next = 0 };
+                uint32_t flags = PTE_U | PTE_OWNED | ((v->flags & VMA_WRITE) ? PTE_W : 0);
+                if (map_pages_flags((void*)va, &pg, current->pd, flags)) {
+                    /* Reclaim drops clean pages and lets them refault; one read
+                       back from swap has no other copy, so it counts as dirty */
+                    if (swapped) mmu_lookup_pte(current->pd, va, 0)->dirty = 1;
+                    pfa_set_owner(frame, current->pd, va);
+                    current->faults++;
+                    current->fault_cycles += (uint32_t)rdtsc() - t0;
+                    return;
+                }
+            }
+            pfa_free(frame);
+        } else if ((from_user || user_va) && current) {
+            esp_printf(putc, "pid %d: out of memory at 0x%p\r\n", current->pid, (void*)cr2);
+        }
+    }
+
+    /* A bad user address is the process's fault even when a syscall
+       touched it on its behalf */
+    if ((from_user || user_va) && current)
+        proc_kill_current(14);
+
+    panic("page fault at 0x%p (err %x, eip 0x%p)", (void*)cr2, tf->err, (void*)tf->eip);
+}
@@ -0,0 +1,75 @@
+// src/proc.h
+#ifndef PROC_H
+#define PROC_H
+
+#include <stdint.h>
+#include "page.h"
+#include "initrd.h"
+#include "vma.h"
+
+#define PROC_MAX         4
+#define PROC_MAX_SEGS    4           // PT_LOAD segments kept per process
+#define USER_STACK_TOP   USER_TOP
+#define USER_STACK_SIZE  0x10000u    // demand-zero stack below USER_STACK_TOP
+#define MMAP_BASE        0x40000000u // mmap() places mappings top-down above this;
+                                     // brk() grows up from the data segment below it
+
+/* Register frame built by trap_common in isr.s */
+struct trapframe {
+    uint32_t gs, fs, es, ds;
+    uint32_t edi, esi, ebp, kesp, ebx, edx, ecx, eax;   // pusha order
+    uint32_t vector, err;
+    uint32_t eip, cs, eflags;
+    uint32_t esp, ss;                // only valid when (cs & 3) != 0
+};
+
+/* A PT_LOAD segment, paged in from the executable on first touch */
+struct proc_seg {
+    uint32_t vaddr;
+    uint32_t memsz;
+    uint32_t filesz;
+    uint32_t offset;                 // file offset of vaddr
+};
+
+enum proc_state { PROC_FREE = 0, PROC_RUNNING };
+
+struct proc {
+    int pid;
+    enum proc_state state;
+    int fd;                          // open executable backing the segments, or
+    struct initrd_file image;        // with fd < 0, the initrd file instead
+    struct page_directory_entry *pd;
+    struct proc_seg seg[PROC_MAX_SEGS];
+    uint32_t nseg;
+    struct vma_tree vmas;            // what each user address is backed by
+    uint32_t brk_start, brk;         // heap: [brk_start, brk)
+    uint32_t kesp;                   // kernel stack saved by user_enter()
+    uint32_t faults;                 // pages faulted in
+    uint32_t shared;                 // of those, initrd pages mapped in place
+    uint32_t fault_cycles;
+};
+
+extern struct proc *current;
+
+/* Load an ELF32 executable, from the initrd if it has 'path' and from the
+   FAT volume otherwise, and run it in ring 3 until it exits. Returns the
+   exit status, or a negative value if it could not be loaded. */
+int proc_exec(const char *path);
+
+/* Leave the current process (from a trap handler) */
+void proc_exit(int code) __attribute__((noreturn));
+void proc_kill_current(uint32_t vector) __attribute__((noreturn));
+
+/* #PF: look the address up in the VMA tree and page in from the
+   executable or a zero-filled frame */
+void proc_page_fault(struct trapframe *tf);
+
+/* 1 if [addr, addr+len) lies entirely in user space */
+int user_range_ok(uint32_t addr, uint32_t len);
+
+/* 1 if every byte of [addr, addr+len) lies in a VMA of the current
+   process with all of the VMA_* 'flags'. Syscalls check buffers with
+   this before touching them; the pages themselves may still fault in. */
+int user_access_ok(uint32_t addr, uint32_t len, uint32_t flags);
+
+#endif // PROC_H
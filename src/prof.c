@@ -0,0 +1,60 @@
+// src/prof.c
+#include <stdint.h>
+#include "page.h"
+#include "prof.h"
+
+#define KERNEL_BASE 0x00100000u
+#define MAX_FRAME   0x4000u      // largest stack frame we trust while walking
+
+volatile int prof_enabled = 1;
+int prof_backtrace = 1;
+
+static struct prof_cpu prof[MAX_CPUS];
+
+void prof_sample(struct interrupt_frame *frame, uint32_t ebp) {
+    struct prof_cpu *p = &prof[cpu_id()];
+
+    if (!prof_enabled) return;
+    if (p->n >= PROF_MAX_SAMPLES) { p->dropped++; return; }
+
+    struct prof_sample *s = &p->s[p->n++];
+    s->pc[0] = frame->eip;
+    s->depth = 1;
+
+    /* Only walk kernel frames; each saved EBP must move up the stack and
+       stay inside the boot identity map, the only memory sure to be mapped */
+    if (!prof_backtrace || (frame->cs & 3)) return;
+
+    uint32_t fp = ebp;
+    while (s->depth < PROF_MAX_DEPTH) {
+        if (fp < KERNEL_BASE || fp > BOOT_MAP_END - 8 || (fp & 3)) break;
+        uint32_t next = ((uint32_t*)fp)[0];
+        uint32_t ret  = ((uint32_t*)fp)[1];
+        if (ret < KERNEL_BASE) break;
+        s->pc[s->depth++] = ret;
+        if (next <= fp || next - fp > MAX_FRAME) break;
+        fp = next;
+    }
+}
+
+void prof_dump(func_ptr out) {
+    int was_on = prof_enabled;
+    prof_enabled = 0;
+
+    for (int c = 0; c < MAX_CPUS; ++c) {
+        struct prof_cpu *p = &prof[c];
+
+        esp_printf(out, "PROF-BEGIN cpu=%d samples=%u dropped=%u\r\n", c, p->n, p->dropped);
+        for (uint32_t i = 0; i < p->n; ++i) {
+            esp_printf(out, "P");
+            for (uint32_t d = 0; d < p->s[i].depth; ++d)
+                esp_printf(out, " %x", p->s[i].pc[d]);
+            esp_printf(out, "\r\n");
+        }
+        esp_printf(out, "PROF-END cpu=%d\r\n", c);
+        p->n = 0;
+        p->dropped = 0;
+    }
+
+    prof_enabled = was_on;
+}
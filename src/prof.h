@@ -0,0 +1,33 @@
+// src/prof.h
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include "cpu.h"
+#include "interrupt.h"
+#include "rprintf.h"
+
+#define PROF_MAX_SAMPLES 2048
+#define PROF_MAX_DEPTH   8       // pc[0] is the interrupted EIP
+
+struct prof_sample {
+    uint32_t depth;
+    uint32_t pc[PROF_MAX_DEPTH];
+};
+
+struct prof_cpu {
+    uint32_t n;
+    uint32_t dropped;            // samples taken while the buffer was full
+    struct prof_sample s[PROF_MAX_SAMPLES];
+};
+
+extern volatile int prof_enabled;
+extern int prof_backtrace;       // 0 = EIP only, 1 = walk EBP frame chain
+
+/* Called from the timer interrupt with the interrupted EIP and EBP */
+void prof_sample(struct interrupt_frame *frame, uint32_t ebp);
+
+/* Print samples as text for tools/prof_symbolize.py, then start over */
+void prof_dump(func_ptr out);
+
+#endif // PROF_H
@@ -45,16 +45,18 @@ static void outs(charptr lp)
 {
     if (lp == NULL) lp = "(null)";
 
+    /* width is measured against what we emit (precision-limited via num2) */
+    len = 0;
+    while (lp[len] && len < num2) len++;
+
     /* pad on left if needed */
-    len = (int)strlen(lp);
     padding(!left_flag);
 
-    /* emit (optionally width-limited via num2) */
-    while (*lp && num2--)
-        out_char(*lp++);
+    /* emit */
+    for (int i = 0; i < len; i++)
+        out_char(lp[i]);
 
     /* pad on right if needed */
-    len = (int)strlen(lp);
     padding(left_flag);
 }
 
@@ -90,40 +92,24 @@ static void outnum_u(unsigned long num, int base)
 /* signed decimal with optional leading '-' */
 static void outnum_s(long val)
 {
-    unsigned long u;
     int neg = (val < 0);
+    unsigned long u = neg ? 0UL - (unsigned long)val : (unsigned long)val;
 
-    if (neg) val = -val;
-    u = (unsigned long)val;
-
-    if (!do_padding || left_flag) {
-        /* no left padding to worry about: print sign first if needed */
-        if (neg) out_char('-');
-        outnum_u(u, 10);
-        return;
-    }
-
-    /* When left-padding with width, we need to account for the '-' in width */
-    /* Compute the decimal digits length */
+    /* build digits backwards; the '-' counts toward the field width */
     char tmp[32];
     char *p = tmp;
-    unsigned long t = u;
-    do { *p++ = (char)('0' + (t % 10)); t /= 10; } while (t);
-    int digits = (int)(p - tmp);
-
-    int needed = digits + (neg ? 1 : 0);
-    len = needed;
+    do { *p++ = (char)('0' + (u % 10)); u /= 10; } while (u);
+    len = (int)(p - tmp) + neg;
 
-    /* left pad (spaces or zeros) */
-    if (do_padding && !left_flag && (len < num1)) {
-        int padcount = num1 - len;
-        while (padcount--) out_char(pad_character);
-    }
-
-    if (neg) out_char('-');
+    /* zero padding goes between the sign and the digits ("-0042") */
+    if (neg && pad_character == '0') out_char('-');
+    padding(!left_flag);
+    if (neg && pad_character != '0') out_char('-');
 
     /* print number */
     while (p != tmp) out_char(*--p);
+
+    padding(left_flag);
 }
 
 /*---------------------------------------------------*/
@@ -172,6 +158,7 @@ void esp_vprintf(const func_ptr f_ptr, charptr ctrl, va_list argp)
 
 try_next:
         ch = *(++ctrl);
+        if (!ch) return;                 /* format ends inside a conversion */
 
         if (isdig((int)ch)) {
             if (dot_flag) {
@@ -251,7 +238,7 @@ try_next:
             case 'n': out_char(0x0D); out_char(0x0A); break;
             default:  out_char(*ctrl); break;
             }
-            ctrl++;
+            if (!*++ctrl) return;
             break;
 
         default:
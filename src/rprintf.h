@@ -6,9 +6,13 @@
 //#include <string.h>
 #include <stdarg.h>
 
+#ifdef HOST_TEST
+#include <stddef.h>                  // native test builds share libc's size_t/NULL
+#else
 typedef unsigned int  size_t;
 
 #define NULL (void*)0
+#endif
 
 int isdig(int c); // hand-implemented alternative to isdigit(), which uses a bunch of c library functions I don't want to include.
 
@@ -0,0 +1,218 @@
+// src/sched.c
+// Kernel threads on a round-robin run queue. Switching is cooperative in
+// the kernel (sleep_on/yield/exit) and preemptive only for ring 3, from
+// the PIT, so nothing else in the kernel needs locks beyond irq_save().
+// A blocked thread sits on a wait queue and costs nothing until woken;
+// with nothing runnable the boot thread halts in sched_idle().
+#include <stdint.h>
+#include "sched.h"
+#include "cpu.h"
+#include "page.h"
+#include "panic.h"
+#include "proc.h"
+#include "rprintf.h"
+
+/* isr.s */
+extern void switch_to(uint32_t *save_esp, uint32_t esp);
+extern void thread_start(void);
+extern struct tss_entry tss_ent;
+
+static struct thread threads[THREAD_MAX];
+static uint8_t stacks[THREAD_MAX][THREAD_STACK_SIZE] __attribute__((aligned(16)));
+static struct wait_queue runq;
+static struct thread *idle_thread;
+static struct page_directory_entry *active_pd;
+static uint32_t slice;
+static int next_tid;
+
+struct thread *current_thread;
+
+// --- Queues ---
+
+static void enqueue(struct wait_queue *q, struct thread *t) {
+    t->next = 0;
+    if (q->tail) q->tail->next = t;
+    else q->head = t;
+    q->tail = t;
+}
+
+static struct thread *dequeue(struct wait_queue *q) {
+    struct thread *t = q->head;
+    if (t) {
+        q->head = t->next;
+        if (!q->head) q->tail = 0;
+        t->next = 0;
+    }
+    return t;
+}
+
+static void make_runnable(struct thread *t) {
+    t->state = T_RUNNABLE;
+    enqueue(&runq, t);
+}
+
+// --- Switching ---
+
+/* Pick the next thread and switch to it. Interrupts must be off. A thread
+   that is still T_RUNNING goes to the back of the run queue. */
+static void schedule(void) {
+    struct thread *prev = current_thread;
+    struct thread *next = dequeue(&runq);
+
+    if (!next) {
+        if (prev->state == T_RUNNING) return;
+        next = idle_thread;
+    }
+    if (prev->state == T_RUNNING && prev != idle_thread)
+        make_runnable(prev);
+
+    next->state = T_RUNNING;
+    slice = 0;
+    if (next == prev) return;
+
+    /* Kernel threads run on whatever page directory is loaded; the kernel
+       half is the same in all of them. */
+    current = next->proc;
+    if (current) {
+        tss_ent.esp0 = current->kesp;
+        if (active_pd != current->pd) {
+            active_pd = current->pd;
+            loadPageDirectory(active_pd);
+        }
+    }
+
+    next->switches++;
+    fpu_switch(next);
+    current_thread = next;
+    switch_to(&prev->esp, next->esp);
+}
+
+void sched_attach(struct proc *p) {
+    uint32_t flags = irq_save();
+    current_thread->proc = current = p;
+    active_pd = p ? p->pd : pd;
+    loadPageDirectory(active_pd);
+    irq_restore(flags);
+}
+
+void sched_init(void) {
+    struct thread *t = &threads[0];
+    t->tid   = next_tid++;
+    t->state = T_RUNNING;
+    t->name  = "idle";
+    idle_thread = current_thread = t;
+    active_pd = pd;
+}
+
+int thread_create(const char *name, void (*fn)(void *), void *arg) {
+    uint32_t flags = irq_save();
+    int i;
+
+    for (i = 1; i < THREAD_MAX; ++i)
+        if (threads[i].state == T_FREE || threads[i].state == T_ZOMBIE) break;
+    if (i == THREAD_MAX) {
+        irq_restore(flags);
+        return -1;
+    }
+
+    /* First switch_to() pops four zeroed registers and returns into
+       thread_start, which finds fn and arg above. */
+    struct thread *t = &threads[i];
+    uint32_t *sp = (uint32_t*)(stacks[i] + THREAD_STACK_SIZE);
+    *--sp = (uint32_t)(uintptr_t)arg;
+    *--sp = (uint32_t)(uintptr_t)fn;
+    *--sp = (uint32_t)(uintptr_t)thread_start;
+    for (int r = 0; r < 4; ++r) *--sp = 0;          // ebp, ebx, esi, edi
+
+    t->tid      = next_tid++;
+    t->name     = name;
+    t->esp      = (uint32_t)(uintptr_t)sp;
+    t->proc     = 0;
+    t->switches = 0;
+    fpu_release(t);
+    make_runnable(t);
+
+    irq_restore(flags);
+    return t->tid;
+}
+
+void thread_exit(void) {
+    irq_save();
+    if (current_thread == idle_thread)
+        panic("idle thread exited");
+    current_thread->state = T_ZOMBIE;   // stack is reused by thread_create()
+    fpu_release(current_thread);
+    schedule();
+    panic("zombie thread %d rescheduled", current_thread->tid);
+}
+
+void yield(void) {
+    uint32_t flags = irq_save();
+    schedule();
+    irq_restore(flags);
+}
+
+void sched_idle(void) {
+    while (1) {
+        asm volatile("cli");
+        if (runq.head)
+            schedule();
+        else
+            asm volatile("sti\n\thlt");  // sti holds off IRQs one instruction
+        asm volatile("sti");
+    }
+}
+
+void sched_tick(struct interrupt_frame *frame) {
+    if ((frame->cs & 3) && ++slice >= SCHED_SLICE_TICKS && runq.head)
+        schedule();
+}
+
+// --- Wait queues ---
+
+void sleep_on(struct wait_queue *wq) {
+    if (current_thread == idle_thread)
+        panic("idle thread would sleep");
+    current_thread->state = T_BLOCKED;
+    enqueue(wq, current_thread);
+    schedule();
+}
+
+void wake_up(struct wait_queue *wq) {
+    uint32_t flags = irq_save();
+    struct thread *t;
+    while ((t = dequeue(wq)))
+        make_runnable(t);
+    irq_restore(flags);
+}
+
+int wake_up_key(struct wait_queue *wq, uint32_t key, int n) {
+    uint32_t flags = irq_save();
+    struct thread **link = &wq->head, *prev = 0;
+    int woken = 0;
+
+    while (*link && woken < n) {
+        struct thread *t = *link;
+        if (t->wait_key != key) {
+            prev = t;
+            link = &t->next;
+            continue;
+        }
+        *link = t->next;
+        if (wq->tail == t) wq->tail = prev;
+        make_runnable(t);
+        woken++;
+    }
+    irq_restore(flags);
+    return woken;
+}
+
+void sched_dump(func_ptr out) {
+    static const char *const names[] = { "free", "runnable", "running", "blocked", "zombie" };
+    for (int i = 0; i < THREAD_MAX; ++i) {
+        struct thread *t = &threads[i];
+        if (t->state == T_FREE) continue;
+        esp_printf(out, "thread %d %s: %s, %u switches%s\r\n", t->tid, (char*)t->name,
+                   (char*)names[t->state], t->switches, t->proc ? ", user" : "");
+    }
+}
@@ -0,0 +1,68 @@
+// src/sched.h
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include "fpu.h"
+#include "interrupt.h"
+#include "rprintf.h"
+
+#define THREAD_MAX         8
+#define THREAD_STACK_SIZE  8192u
+#define SCHED_SLICE_TICKS  10        // 10ms at TIMER_HZ
+
+enum thread_state { T_FREE = 0, T_RUNNABLE, T_RUNNING, T_BLOCKED, T_ZOMBIE };
+
+struct proc;
+
+struct thread {
+    int tid;
+    enum thread_state state;
+    const char *name;
+    uint32_t esp;                    // saved by switch_to()
+    struct proc *proc;               // user process the thread is running, if any
+    struct thread *next;             // run queue or wait queue link
+    uint32_t wait_key;               // futex key while blocked in futex_wait()
+    uint32_t switches;
+    int fpu_used;                    // fpu_state holds a saved image
+    uint8_t fpu_state[FPU_STATE_SIZE] __attribute__((aligned(16)));
+};
+
+/* Threads blocked on some condition, woken in FIFO order */
+struct wait_queue {
+    struct thread *head, *tail;
+};
+
+extern struct thread *current_thread;
+
+/* The boot thread becomes tid 0; it must end up in sched_idle() */
+void sched_init(void);
+
+/* Start fn(arg) on a new kernel thread. Returns the tid, or -1. */
+int  thread_create(const char *name, void (*fn)(void *), void *arg);
+void thread_exit(void) __attribute__((noreturn));
+void yield(void);
+
+/* Run the current thread in p's address space (0 = back to the kernel's) */
+void sched_attach(struct proc *p);
+
+/* Run whatever is runnable; halt when nothing is. Never returns. */
+void sched_idle(void) __attribute__((noreturn));
+
+/* PIT hook: preempt ring 3 once its slice is used up. Kernel code is
+   never preempted, it only switches in sleep_on(), yield() and exit. */
+void sched_tick(struct interrupt_frame *frame);
+
+/* Call with interrupts disabled (irq_save) and re-test the condition in a
+   loop around sleep_on(): a wake_up() from an interrupt handler can then
+   never fall between the test and the sleep. */
+void sleep_on(struct wait_queue *wq);
+void wake_up(struct wait_queue *wq);
+
+/* Wake up to n waiters blocked with this wait_key; returns how many */
+int wake_up_key(struct wait_queue *wq, uint32_t key, int n);
+
+/* Per-thread switch counts and states */
+void sched_dump(func_ptr out);
+
+#endif // SCHED_H
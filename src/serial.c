@@ -0,0 +1,23 @@
+// src/serial.c
+#include <stdint.h>
+#include "serial.h"
+
+extern uint8_t inb(uint16_t _port);
+extern void outb(uint16_t _port, uint8_t val);
+
+void serial_init(void) {
+    outb(COM1_PORT + 1, 0x00);    // no interrupts
+    outb(COM1_PORT + 3, 0x80);    // DLAB on
+    outb(COM1_PORT + 0, 0x01);    // divisor lo: 115200 baud
+    outb(COM1_PORT + 1, 0x00);    // divisor hi
+    outb(COM1_PORT + 3, 0x03);    // 8 bits, no parity, 1 stop, DLAB off
+    outb(COM1_PORT + 2, 0xC7);    // FIFO on, clear, 14-byte threshold
+    outb(COM1_PORT + 4, 0x03);    // DTR + RTS
+}
+
+int serial_putc(int ch) {
+    while ((inb(COM1_PORT + 5) & 0x20) == 0)   // wait for THR empty
+        ;
+    outb(COM1_PORT, (uint8_t)ch);
+    return ch;
+}
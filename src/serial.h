@@ -0,0 +1,14 @@
+// src/serial.h
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#define COM1_PORT 0x3F8
+
+/* Program COM1 for 115200 8N1, no interrupts */
+void serial_init(void);
+
+/* Blocking write of one character; same signature as putc so it can be
+   handed to esp_printf as the output function. */
+int serial_putc(int ch);
+
+#endif // SERIAL_H
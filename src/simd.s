@@ -0,0 +1,49 @@
+# src/simd.s — SSE2 kernels for fpu.c. Call only between kernel_fpu_begin()
+# and kernel_fpu_end(); both pointers must be 16-byte aligned.
+#
+# Non-temporal stores keep a freshly zeroed or copied page from evicting
+# the working set from the cache; the sfence orders them before whatever
+# the caller does next (e.g. mapping the page).
+
+.section .text
+
+# void sse2_zero_page(void *page)
+.global sse2_zero_page
+.type sse2_zero_page, @function
+sse2_zero_page:
+    mov 4(%esp), %eax
+    lea 4096(%eax), %edx
+    pxor %xmm0, %xmm0
+1:
+    movntdq %xmm0, 0(%eax)
+    movntdq %xmm0, 16(%eax)
+    movntdq %xmm0, 32(%eax)
+    movntdq %xmm0, 48(%eax)
+    add $64, %eax
+    cmp %edx, %eax
+    jne 1b
+    sfence
+    ret
+
+# void sse2_copy_page(void *dst, const void *src)
+.global sse2_copy_page
+.type sse2_copy_page, @function
+sse2_copy_page:
+    mov 4(%esp), %eax
+    mov 8(%esp), %ecx
+    lea 4096(%ecx), %edx
+1:
+    movdqa 0(%ecx), %xmm0
+    movdqa 16(%ecx), %xmm1
+    movdqa 32(%ecx), %xmm2
+    movdqa 48(%ecx), %xmm3
+    movntdq %xmm0, 0(%eax)
+    movntdq %xmm1, 16(%eax)
+    movntdq %xmm2, 32(%eax)
+    movntdq %xmm3, 48(%eax)
+    add $64, %ecx
+    add $64, %eax
+    cmp %edx, %ecx
+    jne 1b
+    sfence
+    ret
@@ -20,6 +20,9 @@
 _start:
     cli
     mov $stack_top, %esp
+    xor %ebp, %ebp      # end of the frame chain for prof.c and panic.c
+    push %ebx           # multiboot info (physical)
+    push %eax           # MULTIBOOT_BOOTLOADER_MAGIC
     call main
 1:  hlt
     jmp 1b
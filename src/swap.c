@@ -0,0 +1,149 @@
+// src/swap.c
+// Page reclaim under memory pressure. The page-fault handler records in
+// the PFA's reverse map which user page each frame backs; when pfa_alloc()
+// finds the pool empty, a clock hand sweeps that map using the PTE
+// accessed/dirty bits. Clean pages are simply unmapped (the fault handler
+// rebuilds them from the executable or as zeros); dirty ones go to 4KB
+// slots on the swap partition and the PTE keeps the slot number.
+#include <stdint.h>
+#include "ata.h"
+#include "page.h"
+#include "swap.h"
+#include "terminal.h"
+#include "trace.h"
+
+#define SECTORS_PER_SLOT (4096u / ATA_SECTOR_SIZE)
+
+struct swap_stats swap_stats;
+
+static uint32_t swap_lba;                        // first sector of the partition
+static uint32_t slot_map[SWAP_MAX_SLOTS / 32u];
+static uint32_t slot_hint;
+static uint32_t hand;                            // clock position, a frame index
+
+// --- Slots ---
+
+static int slot_alloc(void) {
+    for (uint32_t n = 0; n < swap_stats.slots; ++n) {
+        uint32_t s = slot_hint + n;
+        if (s >= swap_stats.slots) s -= swap_stats.slots;
+        if (!(slot_map[s >> 5] & (1u << (s & 31)))) {
+            slot_map[s >> 5] |= 1u << (s & 31);
+            slot_hint = s + 1;
+            swap_stats.used++;
+            return (int)s;
+        }
+    }
+    return -1;
+}
+
+void swap_free(uint32_t slot) {
+    if (slot >= swap_stats.slots || !(slot_map[slot >> 5] & (1u << (slot & 31)))) return;
+    slot_map[slot >> 5] &= ~(1u << (slot & 31));
+    swap_stats.used--;
+}
+
+// --- Setup ---
+
+static uint32_t rd32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int swap_init(void) {
+    static uint8_t mbr[ATA_SECTOR_SIZE];
+
+    pfa_set_reclaimer(swap_reclaim);
+    swap_stats = (struct swap_stats){ 0 };
+    for (uint32_t i = 0; i < SWAP_MAX_SLOTS / 32u; ++i) slot_map[i] = 0;
+    slot_hint = hand = 0;
+    if (!ata.present || ata_read(0, 1, mbr) != 0 || mbr[510] != 0x55 || mbr[511] != 0xAA)
+        return -1;
+
+    for (int i = 0; i < 4; ++i) {
+        const uint8_t *e = mbr + 0x1BE + 16 * i;
+        if (e[4] != SWAP_PART_TYPE) continue;
+        uint32_t slots = rd32(e + 12) / SECTORS_PER_SLOT;
+        swap_lba = rd32(e + 8);
+        swap_stats.slots = slots < SWAP_MAX_SLOTS ? slots : SWAP_MAX_SLOTS;
+        esp_printf(putc, "swap: %u KB at LBA %u\r\n", swap_stats.slots * 4u, swap_lba);
+        return 0;
+    }
+    esp_printf(putc, "swap: no type 0x82 partition, clean pages only\r\n");
+    return -1;
+}
+
+// --- Reclaim ---
+
+/* Unmap one cold page and free its frame; -1 if it has to stay */
+static int evict(const struct pfa_owner *o, struct page *pte, uint32_t frame) {
+    uint32_t entry = 0;
+
+    if (pte->dirty) {
+        int slot = slot_alloc();
+        if (slot < 0) return -1;
+        if (ata_write(swap_lba + (uint32_t)slot * SECTORS_PER_SLOT, SECTORS_PER_SLOT,
+                      (const void*)(uintptr_t)frame) != 0) {
+            swap_free((uint32_t)slot);
+            return -1;
+        }
+        TRACE(TR_SWAP_OUT, o->va, (uint32_t)slot, frame);
+        entry = ((uint32_t)slot << 12) | PTE_SWAP;
+        swap_stats.outs++;
+    } else {
+        swap_stats.drops++;
+    }
+    *(uint32_t*)pte = entry;
+    pfa_free(frame);
+    return 0;
+}
+
+uint32_t swap_reclaim(void) {
+    uint32_t total = pfa_total_count(), freed = 0, changed = 0;
+
+    /* Two turns of the hand: the first may only clear accessed bits */
+    for (uint32_t n = 0; n < 2 * total && freed < SWAP_BATCH; ++n) {
+        uint32_t idx = hand;
+        hand = (hand + 1 == total) ? 0 : hand + 1;
+
+        const struct pfa_owner *o = pfa_owner(idx);
+        if (!o) continue;
+        swap_stats.scans++;
+
+        uint32_t frame = pfa_base() + idx * 4096u;
+        struct page *pte = mmu_lookup_pte(o->pd, o->va, 0);
+        if (!pte || !pte->present || (pte->frame << 12) != frame) {
+            pfa_set_owner(frame, 0, 0);          // stale: the mapping moved on
+            continue;
+        }
+        changed = 1;
+        if (pte->accessed) {
+            pte->accessed = 0;                   // second chance
+            continue;
+        }
+        if (evict(o, pte, frame) == 0) freed++;
+    }
+
+    /* Cached translations would keep the cleared accessed bits from being set again */
+    if (changed) flush_tlb();
+    if (!freed) swap_stats.failures++;
+    return freed;
+}
+
+int swap_in(struct page *pte, uint32_t frame) {
+    uint32_t slot = pte->frame;
+
+    if (slot >= swap_stats.slots ||
+        ata_read(swap_lba + slot * SECTORS_PER_SLOT, SECTORS_PER_SLOT, (void*)(uintptr_t)frame) != 0)
+        return -1;
+    TRACE(TR_SWAP_IN, slot, frame, 0);
+    swap_free(slot);
+    *(uint32_t*)pte = 0;
+    swap_stats.ins++;
+    return 0;
+}
+
+void swap_dump(func_ptr out) {
+    esp_printf(out, "swap: %u/%u slots, %u out, %u in, %u clean drops, %u scanned, %u failed passes\r\n",
+               swap_stats.used, swap_stats.slots, swap_stats.outs, swap_stats.ins,
+               swap_stats.drops, swap_stats.scans, swap_stats.failures);
+}
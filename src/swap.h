@@ -0,0 +1,41 @@
+// src/swap.h
+#ifndef SWAP_H
+#define SWAP_H
+
+#include <stdint.h>
+#include "page.h"
+#include "rprintf.h"
+
+#define SWAP_PART_TYPE  0x82         // MBR partition type of the swap area
+#define SWAP_MAX_SLOTS  8192u        // 4KB slots: 32MB of swap at most
+#define SWAP_BATCH      8u           // frames freed per reclaim pass
+
+struct swap_stats {
+    uint32_t slots, used;            // capacity and slots in use
+    uint32_t outs, ins;              // pages written out / read back
+    uint32_t drops;                  // clean pages discarded (refault rebuilds them)
+    uint32_t scans;                  // frames looked at by the clock hand
+    uint32_t failures;               // reclaim passes that freed nothing
+};
+
+extern struct swap_stats swap_stats;
+
+/* Find the first type 0x82 partition on the ATA disk and hook the
+   reclaimer into pfa_alloc(). Without a swap area clean pages are still
+   dropped; returns 0 if one was found. */
+int swap_init(void);
+
+/* Clock over the reverse map: a page whose accessed bit is set gets it
+   cleared and a second chance; otherwise it is dropped when clean or
+   written to swap when dirty. Returns the number of frames freed. */
+uint32_t swap_reclaim(void);
+
+/* Read the slot a swapped-out PTE names into 'frame' and release it */
+int swap_in(struct page *pte, uint32_t frame);
+
+/* Release a slot without reading it (the mapping went away) */
+void swap_free(uint32_t slot);
+
+void swap_dump(func_ptr out);
+
+#endif // SWAP_H
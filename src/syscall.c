@@ -0,0 +1,134 @@
+// src/syscall.c
+#include <stdint.h>
+#include "syscall.h"
+#include "proc.h"
+#include "chan.h"
+#include "futex.h"
+#include "sched.h"
+#include "vma.h"
+
+#undef putc
+extern int putc(int);
+
+#define EFAULT 14
+#define EBADF   9
+#define EAGAIN 11
+#define ENOMEM 12
+#define EINVAL 22
+#define ENOSYS 38
+
+static uint32_t sys_write(uint32_t fd, uint32_t buf, uint32_t len) {
+    if (fd != 1 && fd != 2) return -EBADF;
+    if (!user_access_ok(buf, len, VMA_READ)) return -EFAULT;
+
+    const char *s = (const char*)(uintptr_t)buf;
+    for (uint32_t i = 0; i < len; ++i)
+        putc(s[i]);
+    return len;
+}
+
+/* The sender's buffer must be readable, the receiver's writable */
+static uint32_t sys_chan_xfer(uint32_t ch, uint32_t buf, uint32_t len, int send) {
+    if (!user_access_ok(buf, len, send ? VMA_READ : VMA_WRITE)) return -EFAULT;
+    int r = send ? chan_send(ch, (const void*)(uintptr_t)buf, len)
+                 : chan_recv(ch, (void*)(uintptr_t)buf, len);
+    return r < 0 ? (uint32_t)-EINVAL : (uint32_t)r;
+}
+
+static uint32_t sys_futex(uint32_t addr, uint32_t op, uint32_t val) {
+    if (!user_access_ok(addr, 4, VMA_READ)) return -EFAULT;
+    if (op == FUTEX_WAIT) return futex_wait(addr, val) ? (uint32_t)-EAGAIN : 0;
+    if (op == FUTEX_WAKE) return futex_wake(addr, (int)val);
+    return -EINVAL;
+}
+
+static inline uint32_t page_up(uint32_t x) { return (x + 4095u) & ~4095u; }
+
+/* The heap is made of VMA_HEAP VMAs below page_up(brk). Growing extends
+   the one ending there, or starts a new one when that page was unmapped
+   or replaced; a VMA without VMA_HEAP is never stretched. */
+static uint32_t sys_brk(uint32_t addr) {
+    struct proc *p = current;
+    uint32_t old_end = page_up(p->brk), new_end = page_up(addr);
+
+    if (addr < p->brk_start || addr > MMAP_BASE) return p->brk;
+
+    if (new_end > old_end) {
+        struct vma *next = vma_next(&p->vmas, old_end);
+        struct vma *heap = vma_find(&p->vmas, old_end - 1);
+        if (next && next->start < new_end) return p->brk;
+        if (heap && (heap->flags & VMA_HEAP) && heap->end == old_end)
+            heap->end = new_end;
+        else if (!vma_insert(&p->vmas, old_end, new_end, VMA_READ | VMA_WRITE | VMA_ANON | VMA_HEAP))
+            return p->brk;
+    } else if (new_end < old_end) {
+        if (vma_unmap(&p->vmas, p->pd, new_end, old_end) != 0) return p->brk;
+    }
+    p->brk = addr;
+    return addr;
+}
+
+/* Reserving costs one tree insert; pages arrive one fault at a time */
+static uint32_t sys_mmap(uint32_t addr, uint32_t len, uint32_t prot, uint32_t flags) {
+    struct proc *p = current;
+
+    if (!(flags & MAP_ANONYMOUS) || len == 0 || len > USER_TOP) return -EINVAL;
+    len = page_up(len);
+
+    if (flags & MAP_FIXED) {
+        if ((addr & 0xFFF) || !user_range_ok(addr, len)) return -EINVAL;
+        if (vma_unmap(&p->vmas, p->pd, addr, addr + len) != 0) return -ENOMEM;
+    } else {
+        addr = vma_gap(&p->vmas, len, MMAP_BASE, USER_STACK_TOP - USER_STACK_SIZE);
+        if (!addr) return -ENOMEM;
+    }
+
+    uint32_t vflags = VMA_READ | VMA_ANON | ((prot & PROT_WRITE) ? VMA_WRITE : 0);
+    return vma_insert(&p->vmas, addr, addr + len, vflags) ? addr : (uint32_t)-ENOMEM;
+}
+
+static uint32_t sys_munmap(uint32_t addr, uint32_t len) {
+    if ((addr & 0xFFF) || len == 0 || !user_range_ok(addr, len)) return -EINVAL;
+    return vma_unmap(&current->vmas, current->pd, addr, addr + page_up(len)) ? (uint32_t)-ENOMEM : 0;
+}
+
+void syscall_dispatch(struct trapframe *tf) {
+    switch (tf->eax) {
+    case SYS_EXIT:
+        proc_exit((int)tf->ebx);
+    case SYS_WRITE:
+        tf->eax = sys_write(tf->ebx, tf->ecx, tf->edx);
+        break;
+    case SYS_BRK:
+        tf->eax = sys_brk(tf->ebx);
+        break;
+    case SYS_MMAP:
+        tf->eax = sys_mmap(tf->ebx, tf->ecx, tf->edx, tf->esi);
+        break;
+    case SYS_MUNMAP:
+        tf->eax = sys_munmap(tf->ebx, tf->ecx);
+        break;
+    case SYS_CHAN_CREATE:
+        tf->eax = chan_create();
+        break;
+    case SYS_CHAN_DESTROY:
+        tf->eax = chan_destroy((int)tf->ebx) ? (uint32_t)-EINVAL : 0;
+        break;
+    case SYS_CHAN_SEND:
+        tf->eax = sys_chan_xfer(tf->ebx, tf->ecx, tf->edx, 1);
+        break;
+    case SYS_CHAN_RECV:
+        tf->eax = sys_chan_xfer(tf->ebx, tf->ecx, tf->edx, 0);
+        break;
+    case SYS_FUTEX:
+        tf->eax = sys_futex(tf->ebx, tf->ecx, tf->edx);
+        break;
+    case SYS_YIELD:
+        yield();
+        tf->eax = 0;
+        break;
+    default:
+        tf->eax = -ENOSYS;
+        break;
+    }
+}
@@ -0,0 +1,31 @@
+// src/syscall.h
+#ifndef SYSCALL_H
+#define SYSCALL_H
+
+#include "proc.h"
+
+/* int $0x80: eax = number, ebx/ecx/edx/esi = arguments, result in eax.
+   Keep in sync with user/ulib.h. */
+#define SYS_EXIT        1     // (int status)
+#define SYS_WRITE       4     // (int fd, const void *buf, uint32_t len)
+#define SYS_BRK         45    // (void *addr): new break, or the old one on failure
+#define SYS_MMAP        90    // (void *addr, uint32_t len, int prot, int flags in esi)
+#define SYS_MUNMAP      91    // (void *addr, uint32_t len)
+#define SYS_CHAN_CREATE 20    // ()
+#define SYS_CHAN_SEND   21    // (int ch, const void *buf, uint32_t len), see chan.h
+#define SYS_CHAN_RECV   22    // (int ch, void *buf, uint32_t len)
+#define SYS_FUTEX       23    // (uint32_t *addr, int op, uint32_t val), see futex.h
+#define SYS_YIELD       24    // ()
+#define SYS_CHAN_DESTROY 25   // (int ch): only the creating process may
+
+/* mmap() takes anonymous private mappings only */
+#define PROT_READ       0x1
+#define PROT_WRITE      0x2
+#define PROT_EXEC       0x4
+#define MAP_PRIVATE     0x02
+#define MAP_FIXED       0x10
+#define MAP_ANONYMOUS   0x20
+
+void syscall_dispatch(struct trapframe *tf);
+
+#endif // SYSCALL_H
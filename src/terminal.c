@@ -1,5 +1,6 @@
 // src/terminal.c
 #include <stdint.h>
+#include "kstring.h"
 
 /* --- VGA text mode (80x25), memory starts at 0xB8000 --- */
 #define VGA_COLS 80
@@ -27,12 +28,9 @@ static void clear_row(int r) {
 static void scroll_if_needed(void) {
     if (cur_row < VGA_ROWS) return;
 
-    /* Move rows 1..24 up to rows 0..23 */
-    for (int r = 1; r < VGA_ROWS; ++r) {
-        for (int c = 0; c < VGA_COLS; ++c) {
-            VGA[(r - 1) * VGA_COLS + c] = VGA[r * VGA_COLS + c];
-        }
-    }
+    /* Move rows 1..24 up to rows 0..23 in one block copy: memcpy is the
+       variant chosen for this CPU (rep movsl on a P6, dword loop before) */
+    memcpy((void*)VGA, (const void*)(VGA + VGA_COLS), (VGA_ROWS - 1) * VGA_COLS * 2);
     /* Clear last row and clamp cursor to start of it */
     clear_row(VGA_ROWS - 1);
     cur_row = VGA_ROWS - 1;
@@ -0,0 +1,40 @@
+// src/timer.c
+#include <stdint.h>
+#include "interrupt.h"
+#include "irqstat.h"
+#include "prof.h"
+#include "timer.h"
+#include "sched.h"
+
+extern uint8_t inb(uint16_t _port);
+extern void outb(uint16_t _port, uint8_t val);
+
+volatile uint32_t ticks;
+
+void timer_init(uint32_t hz) {
+    uint32_t divisor = PIT_BASE_HZ / hz;
+
+    outb(0x43, 0x34);                        // channel 0, lo/hi, mode 2
+    outb(0x40, divisor & 0xFF);
+    outb(0x40, (divisor >> 8) & 0xFF);
+    IRQ_clear_mask(0);
+}
+
+__attribute__((interrupt))
+void pit_handler(struct interrupt_frame* frame)
+{
+    uint32_t t0 = irqstat_enter(32);
+
+    ticks++;
+
+    /* Our own prologue pushed the interrupted EBP first, so the saved
+       value at our frame pointer is where the backtrace starts. */
+    uint32_t *fp = (uint32_t*)__builtin_frame_address(0);
+    prof_sample(frame, fp[0]);
+
+    PIC_sendEOI(0);
+    irqstat_exit(32, t0);
+
+    /* Last: this may switch threads, returning here much later */
+    sched_tick(frame);
+}
@@ -0,0 +1,16 @@
+// src/timer.h
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+#define PIT_BASE_HZ 1193182u
+#define TIMER_HZ    1000u
+
+/* Timer ticks since timer_init() */
+extern volatile uint32_t ticks;
+
+/* Program PIT channel 0 as a rate generator at 'hz' and unmask IRQ0 */
+void timer_init(uint32_t hz);
+
+#endif // TIMER_H
@@ -0,0 +1,50 @@
+// src/trace.c
+#include <stdint.h>
+#include "trace.h"
+
+volatile int trace_enabled;          // off until F9 turns it on
+
+static struct trace_ring rings[MAX_CPUS];
+
+/* Each CPU only writes its own ring, so reserving a slot just needs
+   interrupts off for a handful of instructions; no lock is taken. */
+void trace_emit(uint16_t event, uint32_t a0, uint32_t a1, uint32_t a2) {
+    uint32_t flags = irq_save();
+    uint64_t tsc = rdtsc();              // inside irq_save so each ring stays in TSC order
+    struct trace_ring *r = &rings[cpu_id()];
+    struct trace_rec *t = &r->rec[r->head++ & (TRACE_RING_SIZE - 1u)];
+
+    t->tsc_lo = (uint32_t)tsc;
+    t->tsc_hi = (uint32_t)(tsc >> 32);
+    t->cpu    = (uint8_t)cpu_id();
+    t->unused = 0;
+    t->event  = event;
+    t->arg[0] = a0;
+    t->arg[1] = a1;
+    t->arg[2] = a2;
+    irq_restore(flags);
+}
+
+void trace_enable(int on) { trace_enabled = on; }
+
+void trace_dump(func_ptr out) {
+    int was_on = trace_enabled;
+    trace_enabled = 0;
+
+    for (int c = 0; c < MAX_CPUS; ++c) {
+        struct trace_ring *r = &rings[c];
+        uint32_t end   = r->head;
+        uint32_t start = (end > TRACE_RING_SIZE) ? end - TRACE_RING_SIZE : 0;
+
+        esp_printf(out, "TRACE-BEGIN cpu=%d records=%u lost=%u\r\n", c, end - start, start);
+        for (uint32_t i = start; i != end; ++i) {
+            struct trace_rec *t = &r->rec[i & (TRACE_RING_SIZE - 1u)];
+            esp_printf(out, "T %08x%08x %d %d %x %x %x\r\n",
+                       t->tsc_hi, t->tsc_lo, t->cpu, t->event,
+                       t->arg[0], t->arg[1], t->arg[2]);
+        }
+        esp_printf(out, "TRACE-END cpu=%d\r\n", c);
+    }
+
+    trace_enabled = was_on;
+}
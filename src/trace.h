@@ -0,0 +1,62 @@
+// src/trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "cpu.h"
+#include "rprintf.h"
+
+/* Static tracepoints. Keep in sync with EVENTS in tools/trace_decode.py */
+enum trace_event {
+    TR_NONE = 0,
+    TR_PFA_ALLOC,        // a0 = frame address (0 = out of memory), a1 = frame index
+    TR_PFA_FREE,         // a0 = frame address
+    TR_MAP_PAGE,         // a0 = virtual address, a1 = physical address, a2 = page directory
+    TR_IRQ_ENTER,        // a0 = vector
+    TR_IRQ_EXIT,         // a0 = vector, a1 = handler cycles
+    TR_ATA_IO,           // a0 = lba, a1 = sectors, a2 = 1 if write
+    TR_PAGE_FAULT,       // a0 = fault address, a1 = error code, a2 = eip
+    TR_CHAN_SEND,        // a0 = channel, a1 = length, a2 = pages remapped
+    TR_CHAN_RECV,        // a0 = channel, a1 = length (or <= 0), a2 = buffer
+    TR_SWAP_OUT,         // a0 = virtual address, a1 = slot, a2 = frame
+    TR_SWAP_IN,          // a0 = slot, a1 = frame
+    TR_NR_EVENTS
+};
+
+/* One fixed-size binary record (24 bytes) */
+struct trace_rec {
+    uint32_t tsc_lo;
+    uint32_t tsc_hi;
+    uint8_t  cpu;
+    uint8_t  unused;
+    uint16_t event;
+    uint32_t arg[3];
+} __attribute__((packed));
+
+#define TRACE_RING_SIZE 1024u    // records per CPU, power of two
+
+struct trace_ring {
+    uint32_t head;               // total records ever written
+    struct trace_rec rec[TRACE_RING_SIZE];
+};
+
+extern volatile int trace_enabled;
+
+void trace_emit(uint16_t event, uint32_t a0, uint32_t a1, uint32_t a2);
+void trace_enable(int on);
+
+/* Print every buffered record as text lines for tools/trace_decode.py */
+void trace_dump(func_ptr out);
+
+/* Compiled out entirely without CONFIG_TRACE; otherwise one load and a
+   not-taken branch while tracing is switched off, which it is until F9. */
+#ifdef CONFIG_TRACE
+#define TRACE(ev, a0, a1, a2) do { \
+        if (__builtin_expect(trace_enabled, 0)) \
+            trace_emit((ev), (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2)); \
+    } while (0)
+#else
+#define TRACE(ev, a0, a1, a2) do { } while (0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,350 @@
+// src/vma.c
+// Per-address-space VMA sets as red-black trees (CLRS, with one shared
+// black sentinel standing in for every leaf). Nodes come from a fixed
+// pool, like every other kernel table.
+#include <stdint.h>
+#include "vma.h"
+
+static struct vma nil = { .left = &nil, .right = &nil, .parent = &nil, .red = 0 };
+#define NIL (&nil)
+
+static struct vma pool[VMA_POOL];
+static struct vma *free_list;
+static int pool_ready;
+
+// --- Node pool ---
+
+static struct vma *node_alloc(void) {
+    if (!pool_ready) {
+        for (int i = 0; i < VMA_POOL; ++i) {
+            pool[i].left = free_list;
+            free_list = &pool[i];
+        }
+        pool_ready = 1;
+    }
+    struct vma *v = free_list;
+    if (v) free_list = v->left;
+    return v;
+}
+
+static void node_free(struct vma *v) {
+    v->left = free_list;
+    free_list = v;
+}
+
+// --- Red-black tree ---
+
+static void rotate_left(struct vma_tree *t, struct vma *x) {
+    struct vma *y = x->right;
+    x->right = y->left;
+    if (y->left != NIL) y->left->parent = x;
+    y->parent = x->parent;
+    if (x->parent == NIL) t->root = y;
+    else if (x == x->parent->left) x->parent->left = y;
+    else x->parent->right = y;
+    y->left = x;
+    x->parent = y;
+}
+
+static void rotate_right(struct vma_tree *t, struct vma *x) {
+    struct vma *y = x->left;
+    x->left = y->right;
+    if (y->right != NIL) y->right->parent = x;
+    y->parent = x->parent;
+    if (x->parent == NIL) t->root = y;
+    else if (x == x->parent->right) x->parent->right = y;
+    else x->parent->left = y;
+    y->right = x;
+    x->parent = y;
+}
+
+static void insert_fixup(struct vma_tree *t, struct vma *z) {
+    while (z->parent->red) {
+        struct vma *g = z->parent->parent;
+        if (z->parent == g->left) {
+            struct vma *y = g->right;
+            if (y->red) {
+                z->parent->red = 0; y->red = 0; g->red = 1;
+                z = g;
+            } else {
+                if (z == z->parent->right) { z = z->parent; rotate_left(t, z); }
+                z->parent->red = 0; g->red = 1;
+                rotate_right(t, g);
+            }
+        } else {
+            struct vma *y = g->left;
+            if (y->red) {
+                z->parent->red = 0; y->red = 0; g->red = 1;
+                z = g;
+            } else {
+                if (z == z->parent->left) { z = z->parent; rotate_right(t, z); }
+                z->parent->red = 0; g->red = 1;
+                rotate_left(t, g);
+            }
+        }
+    }
+    t->root->red = 0;
+}
+
+static void transplant(struct vma_tree *t, struct vma *u, struct vma *v) {
+    if (u->parent == NIL) t->root = v;
+    else if (u == u->parent->left) u->parent->left = v;
+    else u->parent->right = v;
+    v->parent = u->parent;
+}
+
+static struct vma *minimum(struct vma *x) {
+    while (x->left != NIL) x = x->left;
+    return x;
+}
+
+static void delete_fixup(struct vma_tree *t, struct vma *x) {
+    while (x != t->root && !x->red) {
+        if (x == x->parent->left) {
+            struct vma *w = x->parent->right;
+            if (w->red) {
+                w->red = 0; x->parent->red = 1;
+                rotate_left(t, x->parent);
+                w = x->parent->right;
+            }
+            if (!w->left->red && !w->right->red) {
+                w->red = 1;
+                x = x->parent;
+            } else {
+                if (!w->right->red) {
+                    w->left->red = 0; w->red = 1;
+                    rotate_right(t, w);
+                    w = x->parent->right;
+                }
+                w->red = x->parent->red;
+                x->parent->red = 0; w->right->red = 0;
+                rotate_left(t, x->parent);
+                x = t->root;
+            }
+        } else {
+            struct vma *w = x->parent->left;
+            if (w->red) {
+                w->red = 0; x->parent->red = 1;
+                rotate_right(t, x->parent);
+                w = x->parent->left;
+            }
+            if (!w->right->red && !w->left->red) {
+                w->red = 1;
+                x = x->parent;
+            } else {
+                if (!w->left->red) {
+                    w->right->red = 0; w->red = 1;
+                    rotate_left(t, w);
+                    w = x->parent->left;
+                }
+                w->red = x->parent->red;
+                x->parent->red = 0; w->left->red = 0;
+                rotate_right(t, x->parent);
+                x = t->root;
+            }
+        }
+    }
+    x->red = 0;
+}
+
+// --- Queries ---
+
+void vma_init(struct vma_tree *t) {
+    t->root  = NIL;
+    t->count = 0;
+}
+
+struct vma *vma_next(const struct vma_tree *t, uint32_t addr) {
+    struct vma *x = t->root, *best = 0;
+    while (x != NIL) {
+        if (x->end > addr) { best = x; x = x->left; }
+        else x = x->right;
+    }
+    return best;
+}
+
+struct vma *vma_find(const struct vma_tree *t, uint32_t addr) {
+    struct vma *v = vma_next(t, addr);
+    return (v && v->start <= addr) ? v : 0;
+}
+
+struct vma *vma_succ(const struct vma *v) {
+    if (v->right != NIL) return minimum(v->right);
+    struct vma *p = v->parent;
+    while (p != NIL && v == p->right) { v = p; p = p->parent; }
+    return p == NIL ? 0 : p;
+}
+
+static struct vma *vma_pred(const struct vma *v) {
+    if (v->left != NIL) {
+        v = v->left;
+        while (v->right != NIL) v = v->right;
+        return (struct vma*)v;
+    }
+    struct vma *p = v->parent;
+    while (p != NIL && v == p->left) { v = p; p = p->parent; }
+    return p == NIL ? 0 : p;
+}
+
+/* Highest VMA starting below addr */
+static struct vma *last_below(const struct vma_tree *t, uint32_t addr) {
+    struct vma *x = t->root, *best = 0;
+    while (x != NIL) {
+        if (x->start < addr) { best = x; x = x->right; }
+        else x = x->left;
+    }
+    return best;
+}
+
+uint32_t vma_gap(const struct vma_tree *t, uint32_t len, uint32_t lo, uint32_t hi) {
+    struct vma *v = last_below(t, hi);
+    uint32_t top = hi;
+
+    if (len == 0 || hi < lo || hi - lo < len) return 0;
+    while (1) {
+        uint32_t bottom = (v && v->end > lo) ? v->end : lo;
+        if (bottom < top && top - bottom >= len) return top - len;
+        if (!v || v->start <= lo) return 0;
+        top = v->start;
+        v = vma_pred(v);
+    }
+}
+
+int vma_covers(const struct vma_tree *t, uint32_t start, uint32_t end, uint32_t flags) {
+    while (start < end) {
+        struct vma *v = vma_find(t, start);
+        if (!v || (v->flags & flags) != flags) return 0;
+        start = v->end;
+    }
+    return 1;
+}
+
+// --- Updates ---
+
+struct vma *vma_insert(struct vma_tree *t, uint32_t start, uint32_t end, uint32_t flags) {
+    if (start >= end) return 0;
+    struct vma *n = vma_next(t, start);
+    if (n && n->start < end) return 0;                   // overlap
+
+    /* Grow a neighbour with the same flags rather than take a node, so a
+       run of small mmap()s costs one VMA. Moving n's start down keeps the
+       order: nothing lies between prev and n. */
+    struct vma *prev = last_below(t, start);
+    int join_prev = prev && prev->end == start && prev->flags == flags;
+    int join_next = n && n->start == end && n->flags == flags;
+    if (join_prev && join_next) {
+        prev->end = n->end;
+        vma_remove(t, n);
+        return prev;
+    }
+    if (join_prev) {
+        prev->end = end;
+        return prev;
+    }
+    if (join_next) {
+        n->start = start;
+        return n;
+    }
+
+    struct vma *z = node_alloc();
+    if (!z) return 0;
+    z->start = start;
+    z->end   = end;
+    z->flags = flags;
+
+    struct vma *y = NIL, *x = t->root;
+    while (x != NIL) {
+        y = x;
+        x = (start < x->start) ? x->left : x->right;
+    }
+    z->parent = y;
+    if (y == NIL) t->root = z;
+    else if (start < y->start) y->left = z;
+    else y->right = z;
+    z->left = z->right = NIL;
+    z->red = 1;
+    insert_fixup(t, z);
+    t->count++;
+    return z;
+}
+
+void vma_remove(struct vma_tree *t, struct vma *z) {
+    struct vma *y = z, *x;
+    int y_red = y->red;
+
+    if (z->left == NIL) {
+        x = z->right;
+        transplant(t, z, z->right);
+    } else if (z->right == NIL) {
+        x = z->left;
+        transplant(t, z, z->left);
+    } else {
+        y = minimum(z->right);
+        y_red = y->red;
+        x = y->right;
+        if (y->parent == z) {
+            x->parent = y;
+        } else {
+            transplant(t, y, y->right);
+            y->right = z->right;
+            y->right->parent = y;
+        }
+        transplant(t, z, y);
+        y->left = z->left;
+        y->left->parent = y;
+        y->red = z->red;
+    }
+    if (!y_red) delete_fixup(t, x);
+    t->count--;
+    node_free(z);
+}
+
+int vma_unmap(struct vma_tree *t, struct page_directory_entry *pd, uint32_t start, uint32_t end) {
+    struct vma *v = vma_next(t, start);
+
+    while (v && v->start < end) {
+        uint32_t lo = v->start > start ? v->start : start;
+        uint32_t hi = v->end < end ? v->end : end;
+
+        if (lo == v->start && hi == v->end) {
+            vma_remove(t, v);
+        } else if (lo == v->start) {
+            /* Trimming the head changes the key: reinsert */
+            uint32_t old_end = v->end, flags = v->flags;
+            vma_remove(t, v);
+            vma_insert(t, hi, old_end, flags);
+        } else if (hi == v->end) {
+            v->end = lo;
+        } else {
+            uint32_t old_end = v->end;
+            v->end = lo;
+            if (!vma_insert(t, hi, old_end, v->flags)) {
+                v->end = old_end;
+                return -1;
+            }
+        }
+        mmu_release(pd, lo, (hi - lo) >> 12);
+        v = vma_next(t, hi);
+    }
+    return 0;
+}
+
+void vma_clear(struct vma_tree *t) {
+    while (t->root != NIL)
+        vma_remove(t, t->root);
+}
+
+static int check(const struct vma *x, uint32_t lo, uint32_t hi) {
+    if (x == NIL) return 0;
+    if (x->start >= x->end || x->start < lo || x->end > hi) return -1;
+    if (x->red && (x->left->red || x->right->red)) return -1;
+    int l = check(x->left, lo, x->start);
+    int r = check(x->right, x->end, hi);
+    if (l < 0 || r < 0 || l != r) return -1;
+    return l + !x->red;
+}
+
+int vma_check(const struct vma_tree *t) {
+    if (t->root->red) return -1;
+    return check(t->root, 0, 0xFFFFFFFFu);
+}
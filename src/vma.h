@@ -0,0 +1,63 @@
+// src/vma.h
+#ifndef VMA_H
+#define VMA_H
+
+#include <stdint.h>
+#include "page.h"
+
+#define VMA_POOL   256               // nodes shared by every address space
+
+#define VMA_READ   0x1
+#define VMA_WRITE  0x2
+#define VMA_FILE   0x4               // contents come from the executable
+#define VMA_ANON   0x8               // zero-filled on first touch
+#define VMA_STACK  0x10
+#define VMA_HEAP   0x20              // the brk() area
+
+/* A page-aligned range [start, end) of one address space. VMAs never
+   overlap; the tree is ordered by start (and so also by end). */
+struct vma {
+    uint32_t start, end;
+    uint32_t flags;
+    struct vma *left, *right, *parent;
+    int red;
+};
+
+/* Red-black tree of VMAs: lookups from the fault handler are O(log n) */
+struct vma_tree {
+    struct vma *root;
+    uint32_t count;
+};
+
+void vma_init(struct vma_tree *t);
+
+/* The VMA containing addr, or 0 */
+struct vma *vma_find(const struct vma_tree *t, uint32_t addr);
+
+/* The lowest VMA ending above addr (containing it or wholly after it) */
+struct vma *vma_next(const struct vma_tree *t, uint32_t addr);
+struct vma *vma_succ(const struct vma *v);
+
+/* Add [start, end); 0 if it overlaps an existing VMA or the pool is empty.
+   A neighbour that touches the range and has the same flags is extended
+   instead (both, if the range closes a gap), and that VMA is returned. */
+struct vma *vma_insert(struct vma_tree *t, uint32_t start, uint32_t end, uint32_t flags);
+void vma_remove(struct vma_tree *t, struct vma *v);
+
+/* Highest page-aligned free range of len bytes inside [lo, hi); 0 if none */
+uint32_t vma_gap(const struct vma_tree *t, uint32_t len, uint32_t lo, uint32_t hi);
+
+/* 1 if VMAs with all of 'flags' cover [start, end) without a hole */
+int vma_covers(const struct vma_tree *t, uint32_t start, uint32_t end, uint32_t flags);
+
+/* Remove [start, end) from every VMA, splitting where needed, and release
+   the pages mapped there in pd. Returns -1 if the pool ran out mid-split. */
+int vma_unmap(struct vma_tree *t, struct page_directory_entry *pd, uint32_t start, uint32_t end);
+
+/* Drop every VMA (the pages go with the page directory) */
+void vma_clear(struct vma_tree *t);
+
+/* Black height if the red-black and ordering invariants hold, else -1 */
+int vma_check(const struct vma_tree *t);
+
+#endif // VMA_H
@@ -0,0 +1,36 @@
+// tests/host/host.h
+// Shared helpers for the native test programs. The kernel headers define
+// their own NULL/size_t, so test files include those only where needed.
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+/* xorshift32: deterministic, seedable from the command line */
+static inline uint32_t rnd(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return *s = x;
+}
+
+static inline double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline void report_rate(const char *what, unsigned long ops, double secs) {
+    printf("  %-22s %10lu ops  %8.2f Mops/s\n", what, ops, secs > 0 ? ops / secs / 1e6 : 0.0);
+}
+
+#endif // HOST_H
@@ -0,0 +1,64 @@
+// tests/host/ramdisk.c
+// A RAM-backed stand-in for ata.c, shared by the block-layer tests.
+#include <string.h>
+#include "host.h"
+#include "ramdisk.h"
+
+struct ata_info ata;
+uint8_t *ramdisk;
+unsigned long ramdisk_reads, ramdisk_writes;
+
+void ramdisk_init(uint32_t sectors) {
+    free(ramdisk);
+    ramdisk = calloc(sectors, ATA_SECTOR_SIZE);
+    CHECK(ramdisk);
+    ata.present = 1;
+    ata.dma = 1;
+    ata.sectors = sectors;
+    ramdisk_reads = ramdisk_writes = 0;
+}
+
+/* sched.c's wait queues: bcache.c only sleeps on a block that another
+   thread is reading in, and these tests are single-threaded */
+struct wait_queue;
+
+void sleep_on(struct wait_queue *wq) {
+    (void)wq;
+    CHECK(!"sleep_on() with no other thread");
+}
+
+void wake_up(struct wait_queue *wq) { (void)wq; }
+
+static int ram_xfer(int write, uint32_t lba, struct ata_seg *segs, uint32_t nsegs) {
+    uint64_t off = (uint64_t)lba * ATA_SECTOR_SIZE;
+    uint32_t total = 0;
+
+    CHECK(nsegs >= 1 && nsegs <= ATA_MAX_SEGS);
+    for (uint32_t i = 0; i < nsegs; ++i) {
+        CHECK(segs[i].bytes && segs[i].bytes % ATA_SECTOR_SIZE == 0);
+        total += segs[i].bytes;
+    }
+    CHECK(total / ATA_SECTOR_SIZE <= ATA_MAX_SECTORS);
+    CHECK(off + total <= (uint64_t)ata.sectors * ATA_SECTOR_SIZE);
+
+    for (uint32_t i = 0; i < nsegs; ++i) {
+        if (write) memcpy(ramdisk + off, segs[i].buf, segs[i].bytes);
+        else       memcpy(segs[i].buf, ramdisk + off, segs[i].bytes);
+        off += segs[i].bytes;
+    }
+    if (write) ramdisk_writes++; else ramdisk_reads++;
+    return 0;
+}
+
+int ata_read_segs(uint32_t lba, struct ata_seg *segs, uint32_t nsegs)  { return ram_xfer(0, lba, segs, nsegs); }
+int ata_write_segs(uint32_t lba, struct ata_seg *segs, uint32_t nsegs) { return ram_xfer(1, lba, segs, nsegs); }
+
+int ata_read(uint32_t lba, uint32_t count, void *buf) {
+    struct ata_seg seg = { buf, count * ATA_SECTOR_SIZE };
+    return ram_xfer(0, lba, &seg, 1);
+}
+
+int ata_write(uint32_t lba, uint32_t count, const void *buf) {
+    struct ata_seg seg = { (void*)buf, count * ATA_SECTOR_SIZE };
+    return ram_xfer(1, lba, &seg, 1);
+}
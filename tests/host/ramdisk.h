@@ -0,0 +1,14 @@
+// tests/host/ramdisk.h
+#ifndef RAMDISK_H
+#define RAMDISK_H
+
+#include <stdint.h>
+#include "ata.h"
+
+extern uint8_t *ramdisk;
+extern unsigned long ramdisk_reads, ramdisk_writes;
+
+/* (Re)create a zeroed disk of 'sectors' sectors and mark ata.present */
+void ramdisk_init(uint32_t sectors);
+
+#endif // RAMDISK_H
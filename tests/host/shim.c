@@ -0,0 +1,27 @@
+// tests/host/shim.c
+// Stand-ins for what the kernel image normally provides to page.c, mmu.c
+// and rprintf.c, so they can be linked into a native test binary.
+#include <stdint.h>
+#include "cpu.h"
+
+/* kernel.ld symbol; page.c places the frame pool right after it. Here it
+   is backed by real memory (8192 frames, as PFA_MAX_FRAMES) so tests can
+   use frame addresses the way the kernel does through the identity map. */
+uint8_t _end_kernel[8192u * 4096u] __attribute__((aligned(4096)));
+
+/* cpu.c's boot-time CPUID results: all zero, so mmu.c keeps its 386 paths */
+struct cpu_info cpu_info;
+
+/* terminal.c's putc: count characters instead of drawing them */
+unsigned long shim_putc_count;
+
+int putc(int ch) {
+    shim_putc_count++;
+    return ch;
+}
+
+/* swap.c's slot release, for tests that do not link it (and so never
+   create swap entries); test_swap links the real one */
+__attribute__((weak)) void swap_free(uint32_t slot) {
+    (void)slot;
+}
@@ -0,0 +1,107 @@
+// tests/host/test_bcache.c
+// bcache.c against a RAM disk standing in for ata.c.
+// Usage: test_bcache [seed] [ops]
+#include <string.h>
+#include "host.h"
+#include "ramdisk.h"
+#include "bcache.h"
+
+#define DISK_BLOCKS 512u
+#define DISK_BYTES  (DISK_BLOCKS * BLOCK_SIZE)
+
+static uint8_t model[DISK_BYTES];    // what readers must see
+
+static void fill_disk(uint32_t seed) {
+    ramdisk_init(DISK_BLOCKS * SECTORS_PER_BLOCK);
+    for (uint32_t i = 0; i < DISK_BYTES; i += 4) {
+        uint32_t v = rnd(&seed);
+        memcpy(ramdisk + i, &v, 4);
+    }
+    memcpy(model, ramdisk, DISK_BYTES);
+}
+
+static void test_sequential_readahead(void) {
+    bcache_init();
+    memset(&bcache_stats, 0, sizeof(bcache_stats));
+    ramdisk_reads = 0;
+
+    for (uint32_t b = 0; b < 64; ++b) {
+        struct buf *p = bread(b);
+        CHECK(p && p->blockno == b);
+        CHECK(memcmp(p->data, model + b * BLOCK_SIZE, BLOCK_SIZE) == 0);
+        brelse(p);
+    }
+    /* one device request per BCACHE_READAHEAD blocks */
+    CHECK(ramdisk_reads == 64 / BCACHE_READAHEAD);
+    CHECK(bcache_stats.misses == ramdisk_reads);
+    CHECK(bcache_stats.hits == 64 - ramdisk_reads);
+
+    /* a bulk prefetch of a cold range is a single request */
+    ramdisk_reads = 0;
+    CHECK(bprefetch(200, 16) == 16);
+    CHECK(ramdisk_reads == 1);
+    CHECK(bprefetch(200, 16) == 0);
+    printf("bcache sequential/read-ahead OK\n");
+}
+
+static void test_random(uint32_t seed, unsigned long ops) {
+    struct buf *held[8] = { 0 };
+
+    bcache_init();
+    memset(&bcache_stats, 0, sizeof(bcache_stats));
+    ramdisk_reads = ramdisk_writes = 0;
+
+    double t0 = now_sec();
+    for (unsigned long op = 0; op < ops; ++op) {
+        uint32_t r = rnd(&seed);
+        /* skewed working set: most traffic hits 48 hot blocks */
+        uint32_t blk = (r & 3) ? (r >> 8) % 48 : (r >> 8) % DISK_BLOCKS;
+        uint32_t slot = (r >> 4) & 7;
+
+        if (held[slot]) { brelse(held[slot]); held[slot] = 0; }
+
+        struct buf *b = bread(blk);
+        CHECK(b && b->blockno == blk && b->refcnt >= 1);
+        CHECK(memcmp(b->data, model + blk * BLOCK_SIZE, BLOCK_SIZE) == 0);
+
+        if ((r >> 12) % 4 == 0) {
+            uint32_t off = (r >> 16) % (BLOCK_SIZE - 4);
+            memcpy(b->data + off, &r, 4);
+            memcpy(model + blk * BLOCK_SIZE + off, &r, 4);
+            bwrite(b);
+        }
+
+        if ((r >> 20) % 2) held[slot] = b;     // keep a few blocks pinned
+        else brelse(b);
+    }
+    double t1 = now_sec();
+
+    for (int i = 0; i < 8; ++i) if (held[i]) brelse(held[i]);
+    CHECK(bsync() == 0);
+    CHECK(memcmp(ramdisk, model, DISK_BYTES) == 0);
+
+    printf("bcache random: %lu ops OK (hits %u misses %u read-ahead %u writebacks %u)\n",
+           ops, bcache_stats.hits, bcache_stats.misses, bcache_stats.readahead,
+           bcache_stats.writebacks);
+    report_rate("bread/brelse", ops, t1 - t0);
+
+    /* invalidate drops everything; the next read must come from the device */
+    bcache_invalidate();
+    ramdisk_reads = 0;
+    struct buf *b = bread(0);
+    CHECK(b && ramdisk_reads == 1);
+    brelse(b);
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = (argc > 1) ? (uint32_t)strtoul(argv[1], 0, 0) : 0x1234567u;
+    unsigned long ops = (argc > 2) ? strtoul(argv[2], 0, 0) : 200000;
+    if (!seed) seed = 1;
+
+    fill_disk(seed);
+
+    test_sequential_readahead();
+    test_random(seed, ops);
+    printf("all bcache tests passed\n");
+    return 0;
+}
@@ -0,0 +1,180 @@
+// tests/host/test_chan.c
+// chan.c over the real page.c/mmu.c. Copies go through host buffers;
+// remapped messages go through two windows mapped in the kernel 'pd',
+// whose frames are host memory (see shim.c), so the test can check that
+// frames move between page tables without their contents being copied.
+#include <string.h>
+#include "host.h"
+#include "page.h"
+#include "chan.h"
+#include "proc.h"
+
+struct proc *current;                // proc.c is not linked: kernel context
+
+#define VA_A  0x04000000u
+#define VA_B  0x04400000u
+#define PAGES 16u
+
+static uint32_t frame_of(uint32_t va) {
+    struct page *pte = mmu_lookup_pte(pd, va, 0);
+    return (pte && pte->present) ? pte->frame << 12 : 0;
+}
+
+/* Random message sizes through one channel against a FIFO model */
+static void test_copy(uint32_t seed) {
+    static uint8_t sent[64][CHAN_INLINE_MAX], got[CHAN_INLINE_MAX];
+    static uint32_t sent_len[64];
+    uint32_t head = 0, tail = 0;
+    int ch = chan_create();
+    CHECK(ch >= 0);
+
+    CHECK(chan_send(ch, got, 0) < 0);
+    CHECK(chan_recv(ch, got, sizeof(got)) == 0);      // empty
+
+    for (int op = 0; op < 20000; ++op) {
+        if (rnd(&seed) & 1) {
+            uint32_t len = 1 + rnd(&seed) % ((rnd(&seed) & 3) ? 300 : CHAN_INLINE_MAX);
+            uint8_t *m = sent[head & 63];
+            for (uint32_t i = 0; i < len; ++i) m[i] = (uint8_t)rnd(&seed);
+            int r = chan_send(ch, m, len);
+            if (r == 0) {
+                CHECK(head != tail);                    // full
+            } else {
+                CHECK(r == (int)len && head - tail < 64);
+                sent_len[head++ & 63] = len;
+            }
+        } else {
+            int r = chan_recv(ch, got, sizeof(got));
+            if (head == tail) {
+                CHECK(r == 0);
+            } else {
+                CHECK(r == (int)sent_len[tail & 63]);
+                CHECK(memcmp(got, sent[tail & 63], r) == 0);
+                tail++;
+            }
+        }
+    }
+
+    /* a message longer than the buffer stays queued */
+    while (chan_recv(ch, got, sizeof(got)) > 0) ;
+    CHECK(chan_send(ch, "abcdef", 6) == 6);
+    CHECK(chan_recv(ch, got, 3) < 0);
+    CHECK(chan_recv(ch, got, 6) == 6 && memcmp(got, "abcdef", 6) == 0);
+    CHECK(chan_send(ch, got, CHAN_INLINE_MAX + 1) < 0);
+    CHECK(chan_destroy(ch) == 0);
+    printf("chan copy: OK (%u msgs, %u bytes)\n", chan_stats.copied_msgs, chan_stats.copied_bytes);
+}
+
+static void test_remap(void) {
+    struct ppage pg = { 0, 0 };
+    uint32_t frames[PAGES];
+    static uint8_t out[PAGES * 4096 + 1];
+    int ch = chan_create();
+
+    pfa_init();
+    mmu_init();
+    for (uint32_t i = 0; i < PAGES; ++i) {
+        pg.physical_addr = frames[i] = pfa_alloc();
+        memset((void*)(uintptr_t)frames[i], 'a' + i, 4096);
+        map_pages_flags((void*)(uintptr_t)(VA_A + i * 4096), &pg, pd, PTE_W | PTE_OWNED);
+    }
+    CHECK(mmu_lookup_pte(pd, VA_B, 1));                // B's page table, up front
+    uint32_t free0 = pfa_free_count();
+
+    /* A -> B: the same frames, now mapped at B and gone from A */
+    CHECK(chan_send(ch, (void*)(uintptr_t)VA_A, PAGES * 4096) == PAGES * 4096);
+    for (uint32_t i = 0; i < PAGES; ++i) CHECK(frame_of(VA_A + i * 4096) == 0);
+    CHECK(chan_recv(ch, (void*)(uintptr_t)VA_B, PAGES * 4096) == PAGES * 4096);
+    for (uint32_t i = 0; i < PAGES; ++i) {
+        CHECK(frame_of(VA_B + i * 4096) == frames[i]);
+        CHECK(mmu_lookup_pte(pd, VA_B + i * 4096, 0)->os_specific == (PTE_OWNED >> 9));
+    }
+    CHECK(pfa_free_count() == free0);
+    CHECK(chan_stats.remapped_msgs == 1 && chan_stats.remapped_pages == PAGES);
+
+    /* page-aligned but below chan_remap_min, or not mapped in pd: copied */
+    static uint8_t host_page[2][8192] __attribute__((aligned(4096)));
+    memset(host_page[0], 'x', sizeof(host_page[0]));
+    CHECK(chan_send(ch, host_page[0], 4096) == 4096);
+    CHECK(chan_send(ch, host_page[0], 8192) == 8192);
+    CHECK(chan_recv(ch, host_page[1], 8192) == 4096);
+    CHECK(chan_recv(ch, host_page[1], 8192) == 8192);
+    CHECK(memcmp(host_page[0], host_page[1], 8192) == 0);
+    CHECK(chan_stats.remapped_msgs == 1);
+
+    /* B -> unaligned host buffer: copied out of the frames, which are freed */
+    CHECK(chan_send(ch, (void*)(uintptr_t)VA_B, PAGES * 4096) == PAGES * 4096);
+    CHECK(chan_recv(ch, out + 1, PAGES * 4096) == PAGES * 4096);
+    for (uint32_t i = 0; i < PAGES; ++i) CHECK(out[1 + i * 4096] == 'a' + i && out[(i + 1) * 4096] == 'a' + i);
+    CHECK(pfa_free_count() == free0 + PAGES);
+
+    /* frames still queued are released with the channel */
+    for (uint32_t i = 0; i < PAGES; ++i) {
+        pg.physical_addr = pfa_alloc();
+        map_pages_flags((void*)(uintptr_t)(VA_A + i * 4096), &pg, pd, PTE_W | PTE_OWNED);
+    }
+    CHECK(chan_send(ch, (void*)(uintptr_t)VA_A, PAGES * 4096) == PAGES * 4096);
+    CHECK(chan_destroy(ch) == 0);
+    CHECK(pfa_free_count() == free0 + PAGES);
+    printf("chan remap: OK\n");
+}
+
+/* A process moves pages only within its own VMAs, and receives them only
+   into writable ones: neither end may create mappings the VMA tree does
+   not know about */
+static void test_vma_rules(void) {
+    static struct proc p;
+    struct ppage pg = { 0, 0 };
+    const uint32_t src = USER_BASE + 0x100000, ro = src + 0x10000, dst = src + 0x20000;
+    const uint32_t len = 4 * 4096;
+
+    uint32_t free0 = pfa_free_count();
+    p.pid = 7;
+    vma_init(&p.vmas);
+    p.pd = mmu_create_pd();
+    current = &p;
+    int ch = chan_create();
+    CHECK(p.pd && ch >= 0);
+    CHECK(vma_insert(&p.vmas, src, src + len, VMA_READ | VMA_WRITE | VMA_ANON));
+    CHECK(vma_insert(&p.vmas, ro, ro + len, VMA_READ | VMA_FILE));
+    CHECK(vma_insert(&p.vmas, dst, dst + len, VMA_READ | VMA_WRITE | VMA_ANON));
+    for (uint32_t i = 0; i < 4; ++i) {
+        pg.physical_addr = pfa_alloc();
+        map_pages_flags((void*)(uintptr_t)(src + i * 4096), &pg, p.pd, PTE_U | PTE_W | PTE_OWNED);
+    }
+
+    uint32_t moved = chan_stats.remapped_msgs;
+    CHECK(chan_send(ch, (void*)(uintptr_t)src, len) == (int)len);
+    CHECK(chan_stats.remapped_msgs == moved + 1);
+    CHECK(chan_recv(ch, (void*)(uintptr_t)ro, len) < 0);                // read-only VMA
+    CHECK(chan_recv(ch, (void*)(uintptr_t)(dst + len), len) < 0);       // no VMA at all
+    CHECK(!mmu_lookup_pte(p.pd, ro, 0)->present);
+    CHECK(chan_recv(ch, (void*)(uintptr_t)dst, len) == (int)len);
+    for (uint32_t i = 0; i < 4; ++i) {
+        struct page *pte = mmu_lookup_pte(p.pd, dst + i * 4096, 0);
+        CHECK(pte->present && pte->rw && pte->user);
+    }
+
+    /* Only the creator may destroy a channel; its exit frees what is queued */
+    CHECK(chan_send(ch, (void*)(uintptr_t)dst, len) == (int)len);
+    p.pid = 8;
+    CHECK(chan_destroy(ch) < 0);
+    p.pid = 7;
+    current = 0;
+    chan_release(7);
+    CHECK(chan_send(ch, "x", 1) < 0);
+    vma_clear(&p.vmas);
+    mmu_destroy_pd(p.pd);
+    CHECK(pfa_free_count() == free0);
+    printf("chan VMA rules and ownership: OK\n");
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = (argc > 1) ? (uint32_t)strtoul(argv[1], 0, 0) : 0x2545F491u;
+    if (!seed) seed = 1;
+    test_copy(seed);
+    test_remap();
+    test_vma_rules();
+    printf("all chan tests passed\n");
+    return 0;
+}
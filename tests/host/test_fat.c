@@ -0,0 +1,193 @@
+// tests/host/test_fat.c
+// fat.c over bcache.c over a RAM disk holding a FAT16 image built here:
+// a fragmented file, a large contiguous file, a file with more runs than
+// the extent cache holds, and a subdirectory.
+#include <string.h>
+#include "host.h"
+#include "ramdisk.h"
+#include "bcache.h"
+#include "fat.h"
+
+#define PART_LBA    2048u
+#define SPC         4u                 // 2KB clusters
+#define CLUSTER     (SPC * 512u)
+#define RESERVED    1u
+#define NFATS       2u
+#define ROOT_ENTS   512u
+#define CLUSTERS    4400u              // > 4085, so FAT16
+#define SPF         ((((CLUSTERS + 2) * 2) + 511) / 512)
+#define ROOT_LBA    (PART_LBA + RESERVED + NFATS * SPF)
+#define DATA_LBA    (ROOT_LBA + ROOT_ENTS * 32 / 512)
+#define TOTAL_SECS  (DATA_LBA - PART_LBA + CLUSTERS * SPC)
+
+static uint16_t fat[CLUSTERS + 2];
+static uint32_t next_root_slot;
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t *p, uint32_t v) { put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16)); }
+
+static uint8_t *cluster_ptr(uint32_t c) { return ramdisk + (DATA_LBA + (c - 2) * SPC) * 512u; }
+
+static uint8_t pattern(uint32_t seed, uint32_t off) { return (uint8_t)((off * 2654435761u + seed) >> 13); }
+
+/* Link 'clusters' in order, fill them with the file's byte pattern */
+static void write_chain(const uint32_t *clusters, uint32_t n, uint32_t size, uint32_t seed) {
+    for (uint32_t i = 0; i < n; ++i) {
+        fat[clusters[i]] = (i + 1 < n) ? (uint16_t)clusters[i + 1] : 0xFFFF;
+        uint8_t *p = cluster_ptr(clusters[i]);
+        for (uint32_t b = 0; b < CLUSTER; ++b) {
+            uint32_t off = i * CLUSTER + b;
+            p[b] = off < size ? pattern(seed, off) : 0;
+        }
+    }
+}
+
+static void dirent(uint8_t *e, const char *name83, uint8_t attr, uint32_t first, uint32_t size) {
+    memcpy(e, name83, 11);
+    e[11] = attr;
+    put16(e + 26, (uint16_t)first);
+    put32(e + 28, size);
+}
+
+static uint8_t *root_slot(void) { return ramdisk + ROOT_LBA * 512u + 32u * next_root_slot++; }
+
+static void build_image(void) {
+    ramdisk_init(PART_LBA + TOTAL_SECS);
+    memset(fat, 0, sizeof(fat));
+    fat[0] = 0xFFF8; fat[1] = 0xFFFF;
+    next_root_slot = 0;
+
+    /* MBR with one partition */
+    uint8_t *mbr = ramdisk;
+    mbr[0x1BE + 4] = 0x83;
+    put32(mbr + 0x1BE + 8, PART_LBA);
+    put32(mbr + 0x1BE + 12, TOTAL_SECS);
+    mbr[510] = 0x55; mbr[511] = 0xAA;
+
+    /* BPB */
+    uint8_t *bs = ramdisk + PART_LBA * 512u;
+    put16(bs + 11, 512);
+    bs[13] = SPC;
+    put16(bs + 14, RESERVED);
+    bs[16] = NFATS;
+    put16(bs + 17, ROOT_ENTS);
+    put16(bs + 19, 0);
+    put16(bs + 22, SPF);
+    put32(bs + 32, TOTAL_SECS);
+    bs[510] = 0x55; bs[511] = 0xAA;
+
+    /* volume label and a deleted entry the lookups must skip */
+    dirent(root_slot(), "TESTVOL    ", FAT_ATTR_VOLUME, 0, 0);
+    dirent(root_slot(), "\xE5OLD    TXT", 0, 0, 0);
+
+    /* KERNEL: 3 fragments, out of order on disk */
+    uint32_t kc[] = { 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 15, 16, 17 };
+    uint32_t ksize = 22 * CLUSTER + 123;
+    write_chain(kc, 23, ksize, 1);
+    dirent(root_slot(), "KERNEL     ", 0, 2, ksize);
+
+    /* BIG.BIN: 1MB contiguous */
+    static uint32_t bc[512];
+    for (uint32_t i = 0; i < 512; ++i) bc[i] = 100 + i;
+    write_chain(bc, 512, 512 * CLUSTER, 2);
+    dirent(root_slot(), "BIG     BIN", 0, 100, 512 * CLUSTER);
+
+    /* FRAG.BIN: every other cluster -> 40 runs, more than FAT_MAX_EXTENTS */
+    static uint32_t fc[40];
+    for (uint32_t i = 0; i < 40; ++i) fc[i] = 1000 + 2 * i;
+    write_chain(fc, 40, 40 * CLUSTER - 7, 3);
+    dirent(root_slot(), "FRAG    BIN", 0, 1000, 40 * CLUSTER - 7);
+
+    /* BOOT/GRUB.CFG */
+    uint32_t dc[] = { 2000 }, gc[] = { 2001 };
+    memset(cluster_ptr(2000), 0, CLUSTER);
+    fat[2000] = 0xFFFF;
+    dirent(cluster_ptr(2000), ".          ", FAT_ATTR_DIR, 2000, 0);
+    dirent(cluster_ptr(2000) + 32, "..         ", FAT_ATTR_DIR, 0, 0);
+    dirent(cluster_ptr(2000) + 64, "GRUB    CFG", 0, 2001, 100);
+    write_chain(gc, 1, 100, 4);
+    (void)dc;
+    dirent(root_slot(), "BOOT       ", FAT_ATTR_DIR, 2000, 0);
+
+    for (uint32_t f = 0; f < NFATS; ++f)
+        memcpy(ramdisk + (PART_LBA + RESERVED + f * SPF) * 512u, fat, sizeof(fat));
+}
+
+static void check_file(const char *path, uint32_t size, uint32_t seed, uint32_t rseed) {
+    static uint8_t buf[1 << 20];
+    struct fat_stat st;
+
+    CHECK(fat_stat(path, &st) == 0 && st.size == size && !(st.attr & FAT_ATTR_DIR));
+    int fd = fat_open(path);
+    CHECK(fd >= 0);
+
+    /* whole file with sequential reads of varying size */
+    uint32_t pos = 0;
+    while (pos < size) {
+        uint32_t want = 1 + rnd(&rseed) % 20000;
+        int r = fat_read(fd, buf + pos, want);
+        CHECK(r > 0);
+        pos += (uint32_t)r;
+    }
+    CHECK(pos == size);
+    CHECK(fat_read(fd, buf, 10) == 0);
+    for (uint32_t i = 0; i < size; ++i) CHECK(buf[i] == pattern(seed, i));
+
+    /* random preads, including ones that run past EOF */
+    for (int k = 0; k < 200; ++k) {
+        uint32_t off = rnd(&rseed) % (size + 100);
+        uint32_t len = rnd(&rseed) % 9000;
+        int r = fat_pread(fd, buf, len, off);
+        uint32_t expect = off >= size ? 0 : (len < size - off ? len : size - off);
+        CHECK(r == (int)expect);
+        for (uint32_t i = 0; i < expect; ++i) CHECK(buf[i] == pattern(seed, off + i));
+    }
+    CHECK(fat_close(fd) == 0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = (argc > 1) ? (uint32_t)strtoul(argv[1], 0, 0) : 0xC0FFEEu;
+    if (!seed) seed = 1;
+
+    build_image();
+    bcache_init();
+    CHECK(fat_mount() == 0);
+
+    check_file("/KERNEL", 22 * CLUSTER + 123, 1, seed);
+    check_file("/kernel", 22 * CLUSTER + 123, 1, seed);
+    check_file("/FRAG.BIN", 40 * CLUSTER - 7, 3, seed);
+    check_file("/boot/grub.cfg", 100, 4, seed);
+    CHECK(fat_open("/nope") < 0);
+    CHECK(fat_open("/boot") < 0);
+    CHECK(fat_open("/kernel/x") < 0);
+
+    struct fat_dirent de;
+    const char *names[] = { "KERNEL", "BIG.BIN", "FRAG.BIN", "BOOT" };
+    for (uint32_t i = 0; i < 4; ++i) {
+        CHECK(fat_readdir("/", i, &de) == 1);
+        CHECK(strcmp(de.name, names[i]) == 0);
+    }
+    CHECK(fat_readdir("/", 4, &de) == 0);
+    CHECK(fat_readdir("/boot", 2, &de) == 1 && strcmp(de.name, "GRUB.CFG") == 0 && de.size == 100);
+    printf("fat lookup/readdir/pread OK\n");
+
+    check_file("/BIG.BIN", 512 * CLUSTER, 2, seed);
+
+    /* cold 1MB read of a contiguous file: one request per 64KB prefetch
+       window, one more because the data area is not 4KB aligned, and one
+       for the root directory block that fat_open() looks the name up in */
+    bcache_invalidate();
+    ramdisk_reads = 0;
+    static uint8_t big[1 << 20];
+    int fd = fat_open("/BIG.BIN");
+    double t0 = now_sec();
+    CHECK(fat_read(fd, big, sizeof(big)) == (int)sizeof(big));
+    double t1 = now_sec();
+    fat_close(fd);
+    CHECK(ramdisk_reads == (1u << 20) / (16u * BLOCK_SIZE) + 2);
+    printf("fat 1MB single read: %lu device reads, %.1f MB/s host\n", ramdisk_reads,
+           1.0 / (t1 - t0 > 0 ? t1 - t0 : 1e-9));
+
+    printf("all fat tests passed\n");
+    return 0;
+}
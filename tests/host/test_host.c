@@ -0,0 +1,229 @@
+// tests/host/test_host.c
+// Native tests for the page frame allocator, the page-table builder and
+// the formatter. Usage: test_host [seed] [ops]
+#include <string.h>
+#include "host.h"
+#include "page.h"
+
+typedef int (*func_ptr)(int c);
+void esp_printf(const func_ptr f_ptr, char *ctrl, ...);
+
+extern uint8_t _end_kernel;
+
+#define FRAME 4096u
+
+/* ------------------------------------------------------------------ */
+/* pfa: randomized alloc/free against a first-fit reference model      */
+/* ------------------------------------------------------------------ */
+static void test_pfa_model(uint32_t seed, unsigned long ops) {
+    pfa_init();
+    const uint32_t total = pfa_total_count();
+    const uintptr_t base = ((uintptr_t)&_end_kernel + FRAME - 1) & ~(uintptr_t)(FRAME - 1);
+    uint8_t  *used = calloc(total, 1);
+    uint32_t *live = malloc(total * sizeof(uint32_t));   // allocated indices
+    uint32_t nlive = 0;
+    CHECK(used && live);
+    CHECK(pfa_free_count() == total);
+
+    /* addresses outside the pool must be ignored */
+    pfa_free(0);
+    pfa_free((uint32_t)(base - FRAME));
+    pfa_free((uint32_t)(base + (uintptr_t)total * FRAME));
+    CHECK(pfa_free_count() == total);
+
+    double t0 = now_sec();
+    for (unsigned long op = 0; op < ops; ++op) {
+        if (nlive == 0 || (rnd(&seed) % 100) < 55) {
+            uint32_t want = 0;
+            while (want < total && used[want]) want++;
+            uint32_t got = pfa_alloc();
+            if (want == total) {
+                CHECK(got == 0);
+            } else {
+                CHECK(got == (uint32_t)(base + (uintptr_t)want * FRAME));
+                used[want] = 1;
+                live[nlive++] = want;
+            }
+        } else {
+            uint32_t k = rnd(&seed) % nlive;
+            uint32_t idx = live[k];
+            live[k] = live[--nlive];
+            used[idx] = 0;
+            pfa_free((uint32_t)(base + (uintptr_t)idx * FRAME));
+        }
+        if ((op & 1023) == 0)
+            CHECK(pfa_free_count() == total - nlive);
+    }
+    CHECK(pfa_free_count() == total - nlive);
+    double t1 = now_sec();
+
+    /* exhaustion: every remaining frame, then 0 */
+    uint32_t extra = 0;
+    while (pfa_alloc()) extra++;
+    CHECK(extra == total - nlive);
+    CHECK(pfa_free_count() == 0);
+
+    printf("pfa model: %lu ops OK (%.2fs incl. model)\n", ops, t1 - t0);
+
+    /* reserved frames (a boot module straddling the pool start) are never handed out */
+    pfa_init();
+    pfa_reserve((uint32_t)(base - FRAME), (uint32_t)(base + 3 * FRAME + 1));
+    CHECK(pfa_free_count() == total - 4);
+    CHECK(pfa_alloc() == (uint32_t)(base + 4 * FRAME));
+
+    /* raw throughput on an empty pool */
+    pfa_init();
+    unsigned long n = 0;
+    t0 = now_sec();
+    for (int r = 0; r < 64; ++r) {
+        for (uint32_t i = 0; i < 256; ++i) live[i] = pfa_alloc();
+        for (uint32_t i = 0; i < 256; ++i) pfa_free(live[i]);
+        n += 512;
+    }
+    report_rate("pfa alloc+free x256", n, now_sec() - t0);
+
+    free(used);
+    free(live);
+}
+
+/* ------------------------------------------------------------------ */
+/* mmu: map/unmap properties on the low 4MB table                      */
+/* ------------------------------------------------------------------ */
+static uint32_t pte_word(uint32_t va) {
+    uint32_t w;
+    memcpy(&w, &pt_low[(va >> 12) & 0x3FF], 4);
+    return w;
+}
+
+static void test_mmu_props(uint32_t seed, unsigned long ops) {
+    static uint32_t model[1024];     // expected frame+1 per slot, 0 = unmapped
+    mmu_init();
+    memset(model, 0, sizeof(model));
+
+    for (int i = 0; i < 1024; ++i) CHECK(pte_word((uint32_t)i << 12) == 0);
+
+    double t0 = now_sec();
+    for (unsigned long op = 0; op < ops; ++op) {
+        uint32_t slot = rnd(&seed) & 1023;
+        uint32_t n = 1 + rnd(&seed) % 4;
+        if (slot + n > 1024) n = 1024 - slot;
+
+        if (rnd(&seed) & 1) {
+            struct ppage nodes[4];
+            for (uint32_t i = 0; i < n; ++i) {
+                nodes[i].physical_addr = (rnd(&seed) & 0xFFFFF) << 12;
+                nodes[i].next = (i + 1 < n) ? &nodes[i + 1] : 0;
+            }
+            void *va = (void*)(uintptr_t)(slot << 12);
+            CHECK(map_pages(va, nodes, pd) == va);
+            for (uint32_t i = 0; i < n; ++i) model[slot + i] = (nodes[i].physical_addr >> 12) + 1;
+        } else {
+            unmap_pages((void*)(uintptr_t)(slot << 12), n, pd);
+            for (uint32_t i = 0; i < n; ++i) model[slot + i] = 0;
+        }
+
+        /* the touched range and a random witness must agree with the model */
+        uint32_t w = rnd(&seed) & 1023;
+        uint32_t probe[2] = { slot, w };
+        for (int k = 0; k < 2; ++k) {
+            struct page *p = &pt_low[probe[k]];
+            if (model[probe[k]]) {
+                CHECK(p->present && p->rw && !p->user);
+                CHECK(p->frame == model[probe[k]] - 1);
+            } else {
+                CHECK(pte_word(probe[k] << 12) == 0);
+            }
+        }
+    }
+    double t1 = now_sec();
+
+    CHECK(pd[0].present && pd[0].rw);
+    CHECK(pd[0].frame == (((uint32_t)(uintptr_t)pt_low) >> 12));
+    for (int i = 1; i < 1024; ++i) CHECK(!pd[i].present);
+    for (int i = 0; i < 1024; ++i)
+        CHECK(model[i] ? (pt_low[i].frame == model[i] - 1) : pte_word((uint32_t)i << 12) == 0);
+
+    printf("mmu map/unmap: %lu ops OK\n", ops);
+    report_rate("map/unmap 1-4 pages", ops, t1 - t0);
+}
+
+/* ------------------------------------------------------------------ */
+/* rprintf: differential test against the C library                    */
+/* ------------------------------------------------------------------ */
+static char obuf[512];
+static unsigned olen;
+static int buf_sink(int c) { if (olen < sizeof(obuf) - 1) obuf[olen++] = (char)c; return c; }
+
+static void test_printf_diff(uint32_t seed, unsigned long ops) {
+    /* esp_printf prints hex digits in upper case, so compare with %X */
+    static const char *fmts[][2] = {
+        { "%d",   "%d"   }, { "%u",   "%u"   }, { "%x",   "%X"   },
+        { "%8d",  "%8d"  }, { "%-8d", "%-8d" }, { "%08d", "%08d" },
+        { "%08x", "%08X" }, { "%-6x", "%-6X" }, { "%3u",  "%3u"  },
+    };
+    static const char *strs[] = { "", "a", "kernel", "page frame" };
+    static const char *sfmts[] = { "%s", "%8s", "%-8s", "%.3s", "%-12.4s" };
+    /* formats that end inside a conversion: the C library leaves these
+       undefined, esp_printf prints up to the '%' and stops */
+    static const char *cut[][2] = {
+        { "50%", "50" }, { "%", "" }, { "a%-", "a" }, { "a%08", "a" }, { "a%\\", "a\\" },
+    };
+    char want[512];
+
+    for (unsigned i = 0; i < sizeof(cut) / sizeof(cut[0]); ++i) {
+        char *f = malloc(strlen(cut[i][0]) + 1);   // exact size, so ASan sees overreads
+        strcpy(f, cut[i][0]);
+        olen = 0;
+        esp_printf(buf_sink, f, 0);
+        obuf[olen] = 0;
+        free(f);
+        if (strcmp(obuf, cut[i][1])) {
+            fprintf(stderr, "format '%s': got '%s' want '%s'\n", cut[i][0], obuf, cut[i][1]);
+            exit(1);
+        }
+    }
+
+    double t0 = now_sec();
+    for (unsigned long op = 0; op < ops; ++op) {
+        int v = (int)rnd(&seed);
+        if (op & 1) v %= 1000;
+        unsigned f = rnd(&seed) % (sizeof(fmts) / sizeof(fmts[0]));
+
+        olen = 0;
+        esp_printf(buf_sink, (char*)fmts[f][0], v);
+        obuf[olen] = 0;
+        snprintf(want, sizeof(want), fmts[f][1], v);
+        if (strcmp(obuf, want)) {
+            fprintf(stderr, "format '%s' value %d: got '%s' want '%s'\n", fmts[f][0], v, obuf, want);
+            exit(1);
+        }
+
+        const char *sf = sfmts[rnd(&seed) % 5];
+        const char *str = strs[rnd(&seed) % 4];
+        olen = 0;
+        esp_printf(buf_sink, (char*)sf, (char*)str);
+        obuf[olen] = 0;
+        snprintf(want, sizeof(want), sf, str);
+        if (strcmp(obuf, want)) {
+            fprintf(stderr, "format '%s' value \"%s\": got '%s' want '%s'\n", sf, str, obuf, want);
+            exit(1);
+        }
+    }
+    double t1 = now_sec();
+
+    printf("esp_printf differential: %lu ops OK\n", ops);
+    report_rate("esp_printf (2 calls)", ops, t1 - t0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = (argc > 1) ? (uint32_t)strtoul(argv[1], 0, 0) : 0x2545F491u;
+    unsigned long ops = (argc > 2) ? strtoul(argv[2], 0, 0) : 200000;
+    if (!seed) seed = 1;
+
+    printf("host tests (seed %u)\n", seed);
+    test_pfa_model(seed, ops);
+    test_mmu_props(seed, ops);
+    test_printf_diff(seed, ops);
+    printf("all host tests passed\n");
+    return 0;
+}
@@ -0,0 +1,73 @@
+// tests/host/test_initrd.c
+// initrd.c over a ustar archive built here: nested paths, a directory
+// entry and an empty file, checked for zero-copy pointers and bounds.
+#include <string.h>
+#include "host.h"
+#include "initrd.h"
+
+static uint8_t tar[16 * 512];
+static uint32_t tar_len;
+
+static void add(const char *name, char type, const uint8_t *data, uint32_t size) {
+    uint8_t *h = tar + tar_len;
+    memset(h, 0, 512);
+    strncpy((char*)h, name, 100);
+    snprintf((char*)h + 124, 12, "%011o", size);
+    h[156] = (uint8_t)type;
+    memcpy(h + 257, "ustar", 6);
+    memcpy(h + 263, "00", 2);
+    if (size) memcpy(h + 512, data, size);
+    tar_len += 512 + ((size + 511) & ~511u);
+}
+
+int main(void) {
+    uint8_t hello[1000], notes[600];
+    struct initrd_file f;
+    const void *p;
+
+    for (uint32_t i = 0; i < sizeof(hello); ++i) hello[i] = (uint8_t)(i * 7);
+    for (uint32_t i = 0; i < sizeof(notes); ++i) notes[i] = (uint8_t)(i ^ 0x5A);
+
+    tar_len = 0;
+    add("./", '5', 0, 0);
+    add("./hello", '0', hello, sizeof(hello));
+    add("./etc/", '5', 0, 0);
+    add("./etc/notes.txt", '0', notes, sizeof(notes));
+    add("./empty", 0, 0, 0);
+    memset(tar + tar_len, 0, 1024);                  // end-of-archive
+    tar_len += 1024;
+
+    CHECK(initrd_mount(tar, tar_len) == 3);
+
+    /* lookups tolerate a leading '/' or "./" and nothing else */
+    CHECK(initrd_lookup("/hello", &f) == 0);
+    CHECK(f.data == tar + 2 * 512 && f.size == sizeof(hello));
+    CHECK(initrd_lookup("hello", &f) == 0);
+    CHECK(initrd_lookup("./etc/notes.txt", &f) == 0);
+    CHECK(f.data == tar + 6 * 512 && memcmp(f.data, notes, sizeof(notes)) == 0);
+    CHECK(initrd_lookup("/hell", &f) < 0);
+    CHECK(initrd_lookup("/etc", &f) < 0);            // directories are not files
+    CHECK(initrd_lookup("/empty", &f) == 0 && f.size == 0);
+
+    /* reads hand out pointers into the archive, clipped at EOF */
+    CHECK(initrd_lookup("/hello", &f) == 0);
+    CHECK(initrd_read(&f, 0, 4096, &p) == sizeof(hello) && p == f.data);
+    CHECK(initrd_read(&f, 990, 100, &p) == 10 && p == f.data + 990);
+    CHECK(initrd_read(&f, 1000, 1, &p) == 0);
+    CHECK(initrd_read(&f, 5000, 1, &p) == 0);
+
+    struct initrd_file e;
+    uint32_t n = 0;
+    while (initrd_readdir(n, &e)) n++;
+    CHECK(n == 3);
+    CHECK(initrd_readdir(1, &e) == 1 && e.name_len == 13 && memcmp(e.name, "etc/notes.txt", 13) == 0);
+
+    /* corrupt archives are refused */
+    CHECK(initrd_mount(tar, 2 * 512 + 100) < 0);     // hello's data cut short
+    tar[512 + 257] = 'X';                            // hello's header
+    CHECK(initrd_mount(tar, tar_len) < 0);
+    CHECK(initrd_mount(tar, 100) < 0);
+
+    printf("all initrd tests passed\n");
+    return 0;
+}
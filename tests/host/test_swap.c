@@ -0,0 +1,133 @@
+// tests/host/test_swap.c
+// swap.c over the real page.c/mmu.c and a RAM disk. A fake process maps
+// more pages than the frame pool holds, the way proc_page_fault() would
+// (owner recorded, dirty bit set by hand since no CPU walks these tables);
+// pfa_alloc() must keep succeeding and every page must come back intact.
+#include <string.h>
+#include "host.h"
+#include "page.h"
+#include "swap.h"
+#include "ramdisk.h"
+
+#define SWAP_LBA    2048u
+#define SWAP_SLOTS  2048u
+#define NPAGES      (8192u + 1024u)          // more than PFA_MAX_FRAMES
+#define VA(i)       (USER_BASE + (i) * 4096u)
+
+static int is_dirty(uint32_t i) { return (i % 8) == 0; }
+
+static uint32_t pattern(uint32_t i, uint32_t w) { return (i * 2654435761u) ^ w; }
+
+static void write_mbr(void) {
+    uint8_t *mbr = ramdisk;
+    uint8_t *e = mbr + 0x1BE;
+    e[4] = 0x83;                             // a data partition first
+    e[8] = 0x01;
+    e[12] = 0xFF;
+    e += 16;
+    e[4] = SWAP_PART_TYPE;
+    memcpy(e + 8, &(uint32_t){ SWAP_LBA }, 4);
+    memcpy(e + 12, &(uint32_t){ SWAP_SLOTS * 8 }, 4);
+    mbr[510] = 0x55;
+    mbr[511] = 0xAA;
+}
+
+/* Map page i of the fake process the way the fault handler does */
+static void fault_in(struct page_directory_entry *upd, uint32_t i, uint32_t frame, int swapped) {
+    struct ppage pg = { frame, 0 };
+    CHECK(map_pages_flags((void*)(uintptr_t)VA(i), &pg, upd, PTE_U | PTE_W | PTE_OWNED));
+    struct page *pte = mmu_lookup_pte(upd, VA(i), 0);
+    pte->accessed = 1;
+    pte->dirty = swapped || is_dirty(i);
+    pfa_set_owner(frame, upd, VA(i));
+}
+
+static void check_page(uint32_t i, const uint32_t *w) {
+    for (uint32_t k = 0; k < 1024; k += 255)
+        CHECK(w[k] == (is_dirty(i) ? pattern(i, k) : 0));
+}
+
+int main(void) {
+    ramdisk_init(SWAP_LBA + SWAP_SLOTS * 8);
+    write_mbr();
+    pfa_init();
+    mmu_init();
+    CHECK(swap_init() == 0 && swap_stats.slots == SWAP_SLOTS);
+
+    struct page_directory_entry *upd = mmu_create_pd();
+    CHECK(upd);
+
+    /* Every allocation succeeds although the pool runs dry a thousand pages in */
+    for (uint32_t i = 0; i < NPAGES; ++i) {
+        uint32_t frame = pfa_alloc();
+        CHECK(frame);
+        uint32_t *w = (uint32_t*)(uintptr_t)frame;
+        memset(w, 0, 4096);
+        if (is_dirty(i))
+            for (uint32_t k = 0; k < 1024; ++k) w[k] = pattern(i, k);
+        fault_in(upd, i, frame, 0);
+    }
+    CHECK(swap_stats.outs > 0 && swap_stats.drops > 0);
+    CHECK(swap_stats.used == swap_stats.outs);
+
+    /* A page left cold while the rest are hot is evicted first */
+    uint32_t cold = NPAGES - 1;
+    for (uint32_t i = 0; i < NPAGES; ++i) {
+        struct page *pte = mmu_lookup_pte(upd, VA(i), 0);
+        if (pte->present) pte->accessed = (i != cold);
+    }
+    CHECK(swap_reclaim() == SWAP_BATCH);
+    CHECK(!mmu_lookup_pte(upd, VA(cold), 0)->present);
+
+    /* Read everything back: resident, swapped (dirty) or dropped (clean) */
+    uint32_t resident = 0, swapped = 0, dropped = 0;
+    for (uint32_t i = 0; i < NPAGES; ++i) {
+        struct page *pte = mmu_lookup_pte(upd, VA(i), 0);
+        if (pte->present) {
+            check_page(i, (const uint32_t*)(uintptr_t)(pte->frame << 12));
+            resident++;
+        } else if (pte->os_specific & (PTE_SWAP >> 9)) {
+            CHECK(is_dirty(i));
+            uint32_t frame = pfa_alloc();
+            CHECK(frame);
+            pte = mmu_lookup_pte(upd, VA(i), 0);
+            CHECK(swap_in(pte, frame) == 0);
+            check_page(i, (const uint32_t*)(uintptr_t)frame);
+            fault_in(upd, i, frame, 1);
+            swapped++;
+        } else {
+            CHECK(!is_dirty(i) && *(uint32_t*)pte == 0);
+            dropped++;
+        }
+    }
+    CHECK(swapped > 0 && swap_stats.ins == swapped);
+    printf("swap: %u resident, %u read back, %u dropped clean; %u out, %u scanned\n",
+           resident, swapped, dropped, swap_stats.outs, swap_stats.scans);
+
+    /* Tearing the address space down releases frames and slots alike */
+    mmu_destroy_pd(upd);
+    CHECK(swap_stats.used == 0);
+    CHECK(pfa_free_count() == pfa_total_count());
+
+    /* Without a swap area dirty pages stay put and allocation finally fails */
+    ramdisk_init(64);
+    pfa_init();
+    mmu_init();
+    CHECK(swap_init() != 0);
+    upd = mmu_create_pd();
+    uint32_t mapped = 0, frame;
+    while ((frame = pfa_alloc()) != 0) {
+        struct ppage pg = { frame, 0 };
+        if (!map_pages_flags((void*)(uintptr_t)VA(mapped), &pg, upd, PTE_U | PTE_W | PTE_OWNED)) {
+            pfa_free(frame);                              // no frame left for a page table
+            break;
+        }
+        mmu_lookup_pte(upd, VA(mapped), 0)->dirty = 1;
+        pfa_set_owner(frame, upd, VA(mapped++));
+    }
+    CHECK(mapped > pfa_total_count() - 16 && swap_stats.outs == 0 && swap_stats.failures > 0);
+    mmu_destroy_pd(upd);
+    CHECK(pfa_free_count() == pfa_total_count());
+    printf("all swap tests passed\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+// tests/host/test_vma.c
+// vma.c against a page-granular model: random inserts, removes and
+// unmaps over a small window, checking the red-black invariants after
+// every step. mmu_release() runs on the kernel 'pd' with host frames.
+// Usage: test_vma [seed] [ops]
+#include <string.h>
+#include "host.h"
+#include "page.h"
+#include "vma.h"
+
+#define BASE   0x10000000u
+#define NPAGES 256u                         // 1MB: can never exhaust VMA_POOL
+
+static uint8_t model[NPAGES];               // 0 = hole, else flags
+
+static uint32_t va_of(uint32_t i) { return BASE + i * 4096; }
+
+/* The tree, walked in order, must describe exactly the model */
+static void compare(struct vma_tree *t) {
+    uint32_t covered = 0, n = 0;
+    CHECK(vma_check(t) >= 0);
+    for (struct vma *v = vma_next(t, 0); v; v = vma_succ(v), ++n) {
+        CHECK(v->start >= BASE && v->end <= va_of(NPAGES));
+        for (uint32_t a = v->start; a < v->end; a += 4096)
+            CHECK(model[(a - BASE) >> 12] == v->flags);
+        covered += (v->end - v->start) >> 12;
+    }
+    CHECK(n == t->count);
+    uint32_t want = 0;
+    for (uint32_t i = 0; i < NPAGES; ++i) want += model[i] != 0;
+    CHECK(covered == want);
+    for (uint32_t i = 0; i < NPAGES; i += 7) {
+        struct vma *v = vma_find(t, va_of(i) + 123);
+        CHECK(model[i] ? (v && v->flags == model[i]) : !v);
+    }
+}
+
+static void test_model(uint32_t seed, unsigned long ops) {
+    struct vma_tree t;
+    unsigned long inserts = 0, unmaps = 0;
+    vma_init(&t);
+
+    double t0 = now_sec();
+    for (unsigned long op = 0; op < ops; ++op) {
+        uint32_t a = rnd(&seed) % NPAGES;
+        uint32_t len = 1 + rnd(&seed) % ((rnd(&seed) & 3) ? 8 : 64);
+        if (a + len > NPAGES) len = NPAGES - a;
+        uint32_t r = rnd(&seed) % 10;
+
+        if (r < 6) {
+            uint8_t flags = 1 + rnd(&seed) % 200;
+            int free = 1;
+            for (uint32_t i = a; i < a + len; ++i) free &= !model[i];
+            struct vma *v = vma_insert(&t, va_of(a), va_of(a + len), flags);
+            CHECK(!v == !free);
+            if (v) {
+                memset(model + a, flags, len);
+                inserts++;
+            }
+        } else if (r < 8) {
+            CHECK(vma_unmap(&t, pd, va_of(a), va_of(a + len)) == 0);
+            memset(model + a, 0, len);
+            unmaps++;
+        } else if (t.count) {
+            struct vma *v = vma_next(&t, va_of(a));
+            if (!v) v = vma_next(&t, 0);
+            memset(model + ((v->start - BASE) >> 12), 0, (v->end - v->start) >> 12);
+            vma_remove(&t, v);
+        }
+        compare(&t);
+    }
+    report_rate("vma model ops", ops, now_sec() - t0);
+    printf("vma model: OK (%lu inserts, %lu unmaps, %u left)\n", inserts, unmaps, t.count);
+    vma_clear(&t);
+    CHECK(t.count == 0 && vma_check(&t) == 0);
+}
+
+static void test_gap(void) {
+    struct vma_tree t;
+    vma_init(&t);
+
+    CHECK(vma_gap(&t, 0x1000, BASE, BASE + 0x10000) == BASE + 0xF000);       // top-down
+    CHECK(vma_gap(&t, 0x11000, BASE, BASE + 0x10000) == 0);
+    CHECK(vma_insert(&t, BASE + 0xC000, BASE + 0x10000, VMA_ANON));
+    CHECK(vma_insert(&t, BASE + 0x4000, BASE + 0x8000, VMA_ANON));
+    CHECK(vma_gap(&t, 0x4000, BASE, BASE + 0x10000) == BASE + 0x8000);
+    CHECK(vma_gap(&t, 0x5000, BASE, BASE + 0x10000) == 0);
+    CHECK(vma_gap(&t, 0x3000, BASE + 0x2000, BASE + 0x6000) == 0);
+    CHECK(vma_gap(&t, 0x2000, BASE + 0x1000, BASE + 0x6000) == BASE + 0x2000);
+
+    CHECK(vma_covers(&t, BASE + 0x4000, BASE + 0x8000, VMA_ANON));
+    CHECK(!vma_covers(&t, BASE + 0x7000, BASE + 0xD000, VMA_ANON));      // hole in between
+    CHECK(!vma_covers(&t, BASE + 0x4000, BASE + 0x5000, VMA_WRITE));
+
+    /* an overlapping insert fails and leaves the tree alone */
+    CHECK(!vma_insert(&t, BASE + 0x7000, BASE + 0x9000, VMA_ANON));
+    CHECK(!vma_insert(&t, BASE + 0x3000, BASE + 0x3000, VMA_ANON));
+    CHECK(t.count == 2);
+
+    /* punching a hole splits one VMA into two */
+    CHECK(vma_unmap(&t, pd, BASE + 0x5000, BASE + 0x6000) == 0);
+    CHECK(t.count == 3 && !vma_find(&t, BASE + 0x5000));
+    CHECK(vma_find(&t, BASE + 0x4FFF)->end == BASE + 0x5000);
+    CHECK(vma_find(&t, BASE + 0x6000)->start == BASE + 0x6000);
+    vma_clear(&t);
+    printf("vma gap/split: OK\n");
+}
+
+/* Touching ranges with equal flags share a node, so the pool outlasts
+   thousands of small mmap()s */
+static void test_merge(void) {
+    struct vma_tree t;
+    vma_init(&t);
+
+    for (uint32_t i = 0; i < 4 * VMA_POOL; ++i)
+        CHECK(vma_insert(&t, BASE + 0x1000000 - (i + 1) * 4096, BASE + 0x1000000 - i * 4096, VMA_ANON));
+    CHECK(t.count == 1 && vma_find(&t, BASE + 0x1000000 - 4 * VMA_POOL * 4096)->end == BASE + 0x1000000);
+
+    CHECK(vma_insert(&t, BASE, BASE + 0x1000, VMA_ANON | VMA_WRITE));
+    CHECK(vma_insert(&t, BASE + 0x2000, BASE + 0x3000, VMA_ANON | VMA_WRITE));
+    CHECK(vma_insert(&t, BASE + 0x3000, BASE + 0x4000, VMA_ANON));            // flags differ
+    CHECK(t.count == 4);
+    CHECK(vma_insert(&t, BASE + 0x1000, BASE + 0x2000, VMA_ANON | VMA_WRITE)); // closes the gap
+    CHECK(t.count == 3 && vma_find(&t, BASE)->end == BASE + 0x3000);
+    CHECK(vma_check(&t) >= 0);
+
+    /* unmapping the middle of a merged run splits it again */
+    CHECK(vma_unmap(&t, pd, BASE + 0x1000, BASE + 0x2000) == 0);
+    CHECK(t.count == 4 && vma_check(&t) >= 0);
+    vma_clear(&t);
+    printf("vma merge: OK\n");
+}
+
+/* Unmapping frees exactly the owned frames in range, and only those */
+static void test_release(void) {
+    struct vma_tree t;
+    struct ppage pg = { 0, 0 };
+    const uint32_t va = 0x05FFC000u;                 // straddles a 4MB boundary
+
+    vma_init(&t);
+    CHECK(vma_insert(&t, va, va + 0x8000, VMA_ANON | VMA_READ | VMA_WRITE));
+    CHECK(mmu_lookup_pte(pd, va, 1) && mmu_lookup_pte(pd, va + 0x4000, 1));
+    uint32_t free0 = pfa_free_count();
+
+    for (uint32_t i = 0; i < 8; i += 2) {            // every other page faulted in
+        pg.physical_addr = pfa_alloc();
+        map_pages_flags((void*)(uintptr_t)(va + i * 4096), &pg, pd, PTE_W | PTE_OWNED);
+    }
+    CHECK(pfa_free_count() == free0 - 4);
+
+    CHECK(vma_unmap(&t, pd, va + 0x2000, va + 0x6000) == 0);     // pages 2..5
+    CHECK(pfa_free_count() == free0 - 2);
+    CHECK(!mmu_lookup_pte(pd, va + 0x2000, 0)->present);
+    CHECK(mmu_lookup_pte(pd, va, 0)->present && mmu_lookup_pte(pd, va + 0x6000, 0)->present);
+    CHECK(t.count == 2);
+
+    vma_unmap(&t, pd, 0, 0xFFFFF000u);
+    CHECK(pfa_free_count() == free0 && t.count == 0);
+    printf("vma release: OK\n");
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = (argc > 1) ? (uint32_t)strtoul(argv[1], 0, 0) : 0x9E3779B9u;
+    unsigned long ops = (argc > 2) ? strtoul(argv[2], 0, 0) : 100000;
+    if (!seed) seed = 1;
+    pfa_init();
+    mmu_init();
+    test_gap();
+    test_merge();
+    test_model(seed, ops);
+    test_release();
+    printf("all vma tests passed\n");
+    return 0;
+}
@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+"""Pack files into a ustar archive whose file data starts on 4KB boundaries.
+
+GRUB loads the archive page-aligned, so every page of a member is then a
+page of physical memory the kernel can map into a process as it is
+(src/proc.c). Empty directory entries fill the gaps; initrd_mount() skips
+them and any tar reads the result.
+
+Usage: tools/mkinitrd.py out.tar file...
+"""
+import os
+import sys
+
+BLOCK = 512
+ALIGN = 4096
+
+
+def header(name, size, typeflag):
+    h = bytearray(BLOCK)
+    h[0:len(name)] = name.encode()
+    h[100:108] = b"0000644\0" if typeflag == b"0" else b"0000755\0"
+    h[108:116] = b"0000000\0"                       # uid
+    h[116:124] = b"0000000\0"                       # gid
+    h[124:136] = b"%011o\0" % size
+    h[136:148] = b"%011o\0" % 0                     # mtime: reproducible
+    h[148:156] = b" " * 8                           # checksum, as spaces
+    h[156:157] = typeflag
+    h[257:263] = b"ustar\0"
+    h[263:265] = b"00"
+    h[148:156] = b"%06o\0 " % sum(h)
+    return bytes(h)
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__.strip().splitlines()[-1])
+    out = bytearray()
+    for path in sys.argv[2:]:
+        name = os.path.basename(path)
+        if len(name) >= 100:
+            sys.exit("%s: name too long for ustar" % name)
+        with open(path, "rb") as f:
+            data = f.read()
+        while (len(out) + BLOCK) % ALIGN:
+            out += header("./", 0, b"5")
+        out += header(name, len(data), b"0")
+        out += data + bytes(-len(data) % BLOCK)
+    out += bytes(2 * BLOCK)                         # end-of-archive marker
+    with open(sys.argv[1], "wb") as f:
+        f.write(out)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Turn profiler dumps (F10) captured from COM1 into folded stacks.
+
+Usage: tools/prof_symbolize.py serial.log [--kernel kernel] [--nm nm] > out.folded
+       flamegraph.pl out.folded > profile.svg
+
+Each output line is "outer;...;inner count", the format consumed by
+flamegraph.pl and speedscope. Pass --flat for a per-function EIP histogram.
+"""
+import argparse
+import bisect
+import collections
+import re
+import subprocess
+import sys
+
+SAMPLE = re.compile(r"^P((?: [0-9A-Fa-f]+)+)\s*$")
+
+
+def load_symbols(nm, kernel):
+    out = subprocess.run([nm, "-n", "--defined-only", kernel],
+                         check=True, capture_output=True, text=True).stdout
+    addrs, names = [], []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) != 3 or parts[1] not in "TtWw":
+            continue
+        addrs.append(int(parts[0], 16))
+        names.append(parts[2])
+    return addrs, names
+
+
+def symbolize(addrs, names, pc):
+    i = bisect.bisect_right(addrs, pc) - 1
+    return names[i] if i >= 0 else "0x%x" % pc
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("log", nargs="?", default="-")
+    ap.add_argument("--kernel", default="kernel")
+    ap.add_argument("--nm", default="nm", help="e.g. i686-linux-gnu-nm on ARM hosts")
+    ap.add_argument("--flat", action="store_true")
+    a = ap.parse_args()
+
+    addrs, names = load_symbols(a.nm, a.kernel)
+    src = sys.stdin if a.log == "-" else open(a.log, errors="replace")
+
+    stacks = collections.Counter()
+    for line in src:
+        m = SAMPLE.match(line.strip())
+        if not m:
+            continue
+        pcs = [int(x, 16) for x in m.group(1).split()]
+        # pcs[0] is the interrupted EIP; the rest are return addresses, so
+        # look up pc-1 to land inside the calling instruction.
+        frames = [symbolize(addrs, names, pcs[0])]
+        frames += [symbolize(addrs, names, pc - 1) for pc in pcs[1:]]
+        if a.flat:
+            stacks[frames[0]] += 1
+        else:
+            stacks[";".join(reversed(frames))] += 1
+
+    if not stacks:
+        sys.exit("no profiler samples found")
+    for stack, n in stacks.most_common():
+        print("%s %d" % (stack, n))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""Decode kernel trace dumps (F11) captured from COM1.
+
+Usage: tools/trace_decode.py serial.log [--mhz N]
+
+Run QEMU with e.g. `-serial file:serial.log`, press F11 in the guest, then
+feed the log to this script. Records from all CPUs are merged by TSC.
+"""
+import argparse
+import re
+import sys
+
+# Keep in sync with enum trace_event in src/trace.h
+EVENTS = {
+    0: ("none", ()),
+    1: ("pfa_alloc", ("frame", "index")),
+    2: ("pfa_free", ("frame",)),
+    3: ("map_page", ("va", "pa", "pd")),
+    4: ("irq_enter", ("vector",)),
+    5: ("irq_exit", ("vector", "cycles")),
+    6: ("ata_io", ("lba", "sectors", "write")),
+    7: ("page_fault", ("addr", "err", "eip")),
+    8: ("chan_send", ("chan", "len", "pages")),
+    9: ("chan_recv", ("chan", "len", "buf")),
+    10: ("swap_out", ("va", "slot", "frame")),
+    11: ("swap_in", ("slot", "frame")),
+}
+
+# Arguments printed in decimal; everything else is an address
+DECIMAL = {"index", "cycles", "vector", "lba", "sectors", "write",
+           "chan", "len", "pages", "slot"}
+
+REC = re.compile(r"^T ([0-9A-Fa-f]{16}) (\d+) (\d+) ([0-9A-Fa-f]+) ([0-9A-Fa-f]+) ([0-9A-Fa-f]+)\s*$")
+
+
+def parse(lines):
+    recs = []
+    for line in lines:
+        m = REC.match(line.strip())
+        if not m:
+            continue
+        tsc = int(m.group(1), 16)
+        cpu = int(m.group(2))
+        ev = int(m.group(3))
+        args = [int(m.group(i), 16) for i in (4, 5, 6)]
+        recs.append((tsc, cpu, ev, args))
+    recs.sort(key=lambda r: r[0])
+    return recs
+
+
+def fmt_args(ev, args):
+    _, names = EVENTS.get(ev, ("ev%d" % ev, ()))
+    if not names:
+        return " ".join("0x%x" % a for a in args)
+    out = []
+    for name, val in zip(names, args):
+        out.append("%s=%d" % (name, val) if name in DECIMAL else "%s=0x%x" % (name, val))
+    return " ".join(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("log", nargs="?", default="-")
+    ap.add_argument("--mhz", type=float, default=0.0,
+                    help="TSC frequency; print microseconds instead of cycles")
+    a = ap.parse_args()
+
+    src = sys.stdin if a.log == "-" else open(a.log, errors="replace")
+    recs = parse(src)
+    if not recs:
+        sys.exit("no trace records found")
+
+    t0 = recs[0][0]
+    prev = t0
+    for tsc, cpu, ev, args in recs:
+        rel, delta = tsc - t0, tsc - prev
+        prev = tsc
+        if a.mhz:
+            stamp = "%12.3fus +%9.3f" % (rel / a.mhz, delta / a.mhz)
+        else:
+            stamp = "%14d +%10d" % (rel, delta)
+        name = EVENTS.get(ev, ("ev%d" % ev, ()))[0]
+        print("%s cpu%d %-10s %s" % (stamp, cpu, name, fmt_args(ev, args)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,11 @@
+# user/crt0.s — entry point for user programs: call main, exit with its result
+
+.section .text
+.global _start
+.type _start, @function
+_start:
+    call main
+    mov %eax, %ebx
+    mov $1, %eax        # SYS_EXIT
+    int $0x80
+1:  jmp 1b
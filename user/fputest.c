@@ -0,0 +1,20 @@
+// user/fputest.c
+#include "ulib.h"
+
+/* x87 arithmetic across yields: the first FPU instruction traps to #NM
+   and gets a clean FPU; later slices must find the registers intact */
+int main(void) {
+    double sum = 0.0;
+
+    for (int k = 1; k <= 3000; ++k) {
+        sum += 1.0 / ((double)k * (double)k);
+        if (k % 100 == 0) yield();
+    }
+    /* sum(1/k^2) -> pi^2/6 = 1.644934 */
+    if (sum < 1.6445 || sum > 1.6450) {
+        puts("fputest: wrong result\r\n");
+        return 1;
+    }
+    puts("fputest: x87 state survived context switches\r\n");
+    return 0;
+}
@@ -0,0 +1,15 @@
+// user/hello.c
+#include "ulib.h"
+
+/* 1MB of .bss: costs nothing to load, only the pages touched below are
+   ever faulted in. */
+static char big[1 << 20];
+
+static char msg[] = "Hello from ring 3!\r\n";
+
+int main(void) {
+    big[0] = 1;
+    big[sizeof(big) - 1] = 2;
+    puts(msg);
+    return big[0] + big[sizeof(big) - 1];
+}
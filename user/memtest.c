@@ -0,0 +1,52 @@
+// user/memtest.c
+#include "ulib.h"
+
+#define SPARSE (256u << 20)
+
+static int fail(const char *what) {
+    puts("memtest: ");
+    puts(what);
+    puts(" failed\r\n");
+    return 1;
+}
+
+int main(void) {
+    /* brk: grow by 64KB, touch both ends, give half back */
+    char *heap = sbrk(0);
+    if (sbrk(0x10000) != heap) return fail("sbrk grow");
+    heap[0] = 1;
+    heap[0xFFFF] = 2;
+    if (brk(heap + 0x8000) != heap + 0x8000) return fail("brk shrink");
+    if (brk(heap - 4096) != heap + 0x8000) return fail("brk below start");
+
+    /* Grow again after the top heap page went away, and over a read-only one */
+    if (munmap(heap + 0x7000, 4096) != 0 || sbrk(0x2000) != heap + 0x8000) return fail("brk after munmap");
+    heap[0x9FFF] = 3;
+    if (mmap(heap + 0x9000, 4096, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED) != heap + 0x9000)
+        return fail("mmap fixed in heap");
+    if (sbrk(0x1000) != heap + 0xA000) return fail("brk after mmap");
+    heap[0xAFFF] = 4;
+    if (brk(heap + 0x8000) != heap + 0x8000) return fail("brk shrink again");
+
+    /* A 256MB reservation is one VMA; only the pages touched get frames */
+    uint32_t *big = mmap(0, SPARSE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS);
+    if (big == MAP_FAILED) return fail("mmap");
+    for (uint32_t i = 0; i < 4; ++i)
+        big[i * (SPARSE / 16)] = i + 1;
+    if (big[SPARSE / 4 - 1] != 0) return fail("zero fill");
+
+    /* Punch out the middle; both halves stay usable */
+    if (munmap((char*)big + SPARSE / 4, SPARSE / 2) != 0) return fail("munmap");
+    if (big[0] != 1 || big[3 * (SPARSE / 16)] != 4) return fail("split");
+
+    /* MAP_FIXED back into the hole: fresh zero pages */
+    uint32_t *mid = (uint32_t*)((char*)big + SPARSE / 4);
+    if (mmap(mid, 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED) != mid)
+        return fail("mmap fixed");
+    if (mid[0] != 0) return fail("fixed zero fill");
+    mid[0] = 5;
+
+    if (munmap(big, SPARSE) != 0) return fail("munmap all");
+    puts("memtest: brk/mmap/munmap OK\r\n");
+    return 0;
+}
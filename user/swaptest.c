@@ -0,0 +1,32 @@
+// user/swaptest.c
+#include "ulib.h"
+
+/* More than the kernel's 32MB frame pool: only runs with swap */
+#define SIZE  (40u << 20)
+#define PAGES (SIZE / 4096)
+
+int main(void) {
+    uint32_t *mem = mmap(0, SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS);
+    if (mem == MAP_FAILED) {
+        puts("swaptest: mmap failed\r\n");
+        return 1;
+    }
+
+    for (uint32_t p = 0; p < PAGES; ++p) {
+        mem[p * 1024] = p ^ 0x5A5A5A5Au;
+        mem[p * 1024 + 1023] = ~p;
+    }
+
+    /* Twice over: every page has been evicted at least once by now */
+    for (int pass = 0; pass < 2; ++pass) {
+        for (uint32_t p = 0; p < PAGES; ++p) {
+            if (mem[p * 1024] != (p ^ 0x5A5A5A5Au) || mem[p * 1024 + 1023] != ~p) {
+                puts("swaptest: page contents lost\r\n");
+                return 2;
+            }
+        }
+    }
+    munmap(mem, SIZE);
+    puts("swaptest: 40MB working set verified\r\n");
+    return 0;
+}
@@ -0,0 +1,113 @@
+// user/ulib.h
+#ifndef ULIB_H
+#define ULIB_H
+
+#include <stdint.h>
+
+/* System call numbers; keep in sync with src/syscall.h */
+#define SYS_EXIT        1
+#define SYS_WRITE       4
+#define SYS_BRK         45
+#define SYS_MMAP        90
+#define SYS_MUNMAP      91
+#define SYS_CHAN_CREATE 20
+#define SYS_CHAN_SEND   21
+#define SYS_CHAN_RECV   22
+#define SYS_FUTEX       23
+#define SYS_YIELD       24
+#define SYS_CHAN_DESTROY 25
+
+#define FUTEX_WAIT      0
+#define FUTEX_WAKE      1
+
+#define PROT_READ       0x1
+#define PROT_WRITE      0x2
+#define MAP_PRIVATE     0x02
+#define MAP_FIXED       0x10
+#define MAP_ANONYMOUS   0x20
+#define MAP_FAILED      ((void*)-1)
+
+static inline int syscall3(int num, uint32_t a, uint32_t b, uint32_t c) {
+    int ret;
+    asm volatile("int $0x80" : "=a"(ret) : "a"(num), "b"(a), "c"(b), "d"(c) : "memory");
+    return ret;
+}
+
+static inline int syscall4(int num, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    int ret;
+    asm volatile("int $0x80" : "=a"(ret) : "a"(num), "b"(a), "c"(b), "d"(c), "S"(d) : "memory");
+    return ret;
+}
+
+static inline void exit(int status) {
+    syscall3(SYS_EXIT, (uint32_t)status, 0, 0);
+    while (1) ;
+}
+
+static inline int write(int fd, const void *buf, uint32_t len) {
+    return syscall3(SYS_WRITE, (uint32_t)fd, (uint32_t)buf, len);
+}
+
+/* Returns the new break, or the current one if addr was refused */
+static inline void *brk(void *addr) {
+    return (void*)syscall3(SYS_BRK, (uint32_t)addr, 0, 0);
+}
+
+static inline void *sbrk(int incr) {
+    char *old = brk(0);
+    return (incr == 0 || brk(old + incr) == old + incr) ? old : (void*)-1;
+}
+
+/* Anonymous mappings only; nothing is allocated until a page is touched */
+static inline void *mmap(void *addr, uint32_t len, int prot, int flags) {
+    int r = syscall4(SYS_MMAP, (uint32_t)addr, len, (uint32_t)prot, (uint32_t)flags);
+    return (r < 0 && r > -4096) ? MAP_FAILED : (void*)r;
+}
+
+static inline int munmap(void *addr, uint32_t len) {
+    return syscall3(SYS_MUNMAP, (uint32_t)addr, len, 0);
+}
+
+/* Page-aligned sends of 8KB or more give the pages away: the buffer reads
+   back as zeros afterwards. Both calls return 0 when full/empty. */
+static inline int chan_create(void) {
+    return syscall3(SYS_CHAN_CREATE, 0, 0, 0);
+}
+
+/* Frees the messages still queued; channels also go when the process exits */
+static inline int chan_destroy(int ch) {
+    return syscall3(SYS_CHAN_DESTROY, (uint32_t)ch, 0, 0);
+}
+
+static inline int chan_send(int ch, const void *buf, uint32_t len) {
+    return syscall3(SYS_CHAN_SEND, (uint32_t)ch, (uint32_t)buf, len);
+}
+
+static inline int chan_recv(int ch, void *buf, uint32_t len) {
+    return syscall3(SYS_CHAN_RECV, (uint32_t)ch, (uint32_t)buf, len);
+}
+
+/* Sleep while *addr == val (-EAGAIN if it already differs) / wake n waiters */
+static inline int futex_wait(volatile uint32_t *addr, uint32_t val) {
+    return syscall3(SYS_FUTEX, (uint32_t)addr, FUTEX_WAIT, val);
+}
+
+static inline int futex_wake(volatile uint32_t *addr, int n) {
+    return syscall3(SYS_FUTEX, (uint32_t)addr, FUTEX_WAKE, (uint32_t)n);
+}
+
+static inline void yield(void) {
+    syscall3(SYS_YIELD, 0, 0, 0);
+}
+
+static inline uint32_t strlen(const char *s) {
+    uint32_t n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+static inline void puts(const char *s) {
+    write(1, s, strlen(s));
+}
+
+#endif // ULIB_H